@@ -0,0 +1,621 @@
+/**
+ * @brief
+ * fjson的性能基准：对每份语料测量解析与序列化的吞吐（MB/s）、每个文档的分配次数与字节数，
+ * 以及每项测试期间的峰值RSS。语料包括test/test.json（或命令行给出的文件）以及生成的
+ * 数字密集、字符串密集、深层嵌套、宽对象四类数据，生成使用固定的种子，结果可以复现。
+ * 每份语料还测量并行解析、懒加载取单个值、磁带加载，顶层为数组时再测按行拆分后的NDJSON读取；
+ * 另有一份12个字段的结构体数组，比较FJSON_FIELDS直接解码与先解析再逐字段读取。
+ *
+ * 用法：bench [--json] [--baseline FILE] [--size MB] [--min-time SEC] [--only NAME] [FILE...]
+ *   --json      每项结果输出一行json（NDJSON）到stdout，便于保存后做回归比较
+ *   --baseline  读取之前--json的输出，打印每项吞吐相对基线的变化
+ *   --size      每份生成语料的大致大小，默认4MB
+ *   --min-time  每项测试至少运行的秒数，默认0.5
+ *   --only      只运行名称包含NAME的语料
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+#include "magnum/fjson/lazy_document.h"
+#include "magnum/fjson/ndjson.h"
+#include "magnum/fjson/parser.h"
+#include "magnum/fjson/tape.h"
+#include "magnum/fjson/writer.h"
+
+namespace
+{
+    //全局operator new的计数，pmr的默认resource同样经过这里
+    std::atomic<size_t> g_allocs{0};
+    std::atomic<size_t> g_alloc_bytes{0};
+    //累加每次的结果，防止被测的代码被优化掉
+    std::atomic<size_t> g_sink{0};
+
+    void *counted_alloc(size_t size, size_t align)
+    {
+        g_allocs.fetch_add(1, std::memory_order_relaxed);
+        g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+        if (size == 0)
+            size = 1;
+        void *ptr = align <= alignof(std::max_align_t)
+                        ? std::malloc(size)
+                        : std::aligned_alloc(align, (size + align - 1) / align * align);
+        if (ptr == nullptr)
+            throw std::bad_alloc();
+        return ptr;
+    }
+} // namespace
+
+void *operator new(size_t size)
+{
+    return counted_alloc(size, alignof(std::max_align_t));
+}
+
+void *operator new(size_t size, std::align_val_t align)
+{
+    return counted_alloc(size, static_cast<size_t>(align));
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace
+{
+    using clock_type = std::chrono::steady_clock;
+
+    struct Options
+    {
+        bool json = false;
+        std::string baseline;
+        size_t size = 4 << 20;
+        double min_time = 0.5;
+        std::string only;
+        std::vector<std::string> files;
+    };
+
+    struct Corpus
+    {
+        std::string name;
+        std::string text;
+    };
+
+    struct Result
+    {
+        std::string corpus;
+        std::string bench;
+        size_t bytes = 0; //每次处理的字节数，解析为输入大小，序列化为输出大小
+        size_t iterations = 0;
+        double median_mbps = 0;
+        double best_mbps = 0;
+        double allocs_per_doc = 0;
+        double alloc_bytes_per_doc = 0;
+        size_t peak_rss_kb = 0;
+    };
+
+    //峰值RSS：Linux上先通过clear_refs重置VmHWM，从而得到单项测试期间的峰值
+    void reset_peak_rss()
+    {
+#if defined(__linux__)
+        std::ofstream out("/proc/self/clear_refs");
+        out << "5";
+#endif
+    }
+
+    size_t peak_rss_kb()
+    {
+#if defined(__linux__)
+        std::ifstream in("/proc/self/status");
+        std::string line;
+        while (std::getline(in, line))
+        {
+            if (line.compare(0, 6, "VmHWM:") == 0)
+                return std::strtoull(line.c_str() + 6, nullptr, 10);
+        }
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<size_t>(usage.ru_maxrss);
+#else
+        return 0;
+#endif
+    }
+
+    //生成的语料：每类重复同一种形状的记录直到达到目标大小
+    std::string generate(size_t target, const std::function<void(std::string &, std::mt19937_64 &)> &record)
+    {
+        std::mt19937_64 rng(20240601);
+        std::string out = "[";
+        while (out.size() < target)
+        {
+            if (out.size() > 1)
+                out += ",\n";
+            record(out, rng);
+        }
+        out += "]";
+        return out;
+    }
+
+    std::string gen_numbers(size_t target)
+    {
+        return generate(target, [](std::string &out, std::mt19937_64 &rng)
+                        {
+                            out += "[";
+                            for (int i = 0; i < 16; i++)
+                            {
+                                if (i > 0)
+                                    out += ",";
+                                switch (i % 4)
+                                {
+                                case 0:
+                                    out += std::to_string(static_cast<int32_t>(rng() % 2000000) - 1000000);
+                                    break;
+                                case 1:
+                                    out += std::to_string(rng());
+                                    break;
+                                case 2:
+                                    out += std::to_string(static_cast<double>(rng() % 1000000) / 1000.0);
+                                    break;
+                                default:
+                                {
+                                    char buf[32];
+                                    std::snprintf(buf, sizeof(buf), "%.17g", std::ldexp(static_cast<double>(rng() % 100000), -static_cast<int>(rng() % 60)));
+                                    out += buf;
+                                    break;
+                                }
+                                }
+                            }
+                            out += "]"; });
+    }
+
+    std::string gen_strings(size_t target)
+    {
+        static const char *const words[] = {"alpha", "beta", "gamma", "delta", "中文", "données", "line\\nbreak",
+                                            "tab\\tbed", "quote\\\"d", "\\u00e9t\\u00e9", "emoji \\ud83d\\ude00", "path\\/to"};
+        return generate(target, [](std::string &out, std::mt19937_64 &rng)
+                        {
+                            out += "[";
+                            for (int i = 0; i < 8; i++)
+                            {
+                                if (i > 0)
+                                    out += ",";
+                                out += "\"";
+                                const size_t count = 1 + rng() % 24;
+                                for (size_t w = 0; w < count; w++)
+                                {
+                                    if (w > 0)
+                                        out += " ";
+                                    out += words[rng() % (sizeof(words) / sizeof(words[0]))];
+                                }
+                                out += "\"";
+                            }
+                            out += "]"; });
+    }
+
+    std::string gen_nested(size_t target)
+    {
+        //默认深度上限之内的深层嵌套，对象与数组交替
+        return generate(target, [](std::string &out, std::mt19937_64 &rng)
+                        {
+                            const int depth = 100 + static_cast<int>(rng() % 300);
+                            for (int d = 0; d < depth; d++)
+                                out += d % 2 ? "[" : "{\"k\":";
+                            out += std::to_string(rng() % 1000);
+                            for (int d = depth - 1; d >= 0; d--)
+                                out += d % 2 ? "]" : "}"; });
+    }
+
+    std::string gen_wide(size_t target)
+    {
+        return generate(target, [](std::string &out, std::mt19937_64 &rng)
+                        {
+                            out += "{";
+                            for (int i = 0; i < 1000; i++)
+                            {
+                                if (i > 0)
+                                    out += ",";
+                                out += "\"field_" + std::to_string(i) + "\":";
+                                if (i % 3 == 0)
+                                    out += std::to_string(rng() % 100000);
+                                else if (i % 3 == 1)
+                                    out += "\"v" + std::to_string(rng() % 1000) + "\"";
+                                else
+                                    out += rng() % 2 ? "true" : "null";
+                            }
+                            out += "}"; });
+    }
+
+    //典型的接口数据：12个字段，另有一个不认识的字段需要跳过
+    struct Dto
+    {
+        int64_t id = 0;
+        std::string name;
+        std::string email;
+        int age = 0;
+        double score = 0;
+        bool active = false;
+        std::vector<std::string> tags;
+        std::string city;
+        std::string zip;
+        double balance = 0;
+        int64_t created = 0;
+        std::optional<std::string> note;
+        FJSON_FIELDS(Dto, FJSON_FIELD(id), FJSON_FIELD(name), FJSON_FIELD(email), FJSON_FIELD(age),
+                     FJSON_FIELD(score), FJSON_FIELD(active), FJSON_FIELD(tags), FJSON_FIELD(city),
+                     FJSON_FIELD(zip), FJSON_FIELD(balance), FJSON_FIELD(created), FJSON_FIELD(note))
+    };
+
+    //FromJSON的顶层需要是声明了字段的结构体
+    struct DtoPage
+    {
+        std::vector<Dto> items;
+        FJSON_FIELDS(DtoPage, FJSON_FIELD(items))
+    };
+
+    std::string gen_dto(size_t target)
+    {
+        return "{\"items\":" + generate(target, [](std::string &out, std::mt19937_64 &rng)
+                        {
+                            const uint64_t id = rng() % 100000000;
+                            out += "{\"id\":" + std::to_string(id);
+                            out += ",\"name\":\"user" + std::to_string(id) + "\"";
+                            out += ",\"email\":\"user" + std::to_string(id) + "@example.com\"";
+                            out += ",\"age\":" + std::to_string(18 + rng() % 60);
+                            out += ",\"score\":" + std::to_string(static_cast<double>(rng() % 100000) / 100.0);
+                            out += rng() % 2 ? ",\"active\":true" : ",\"active\":false";
+                            out += ",\"tags\":[\"a\",\"b" + std::to_string(rng() % 10) + "\"]";
+                            out += ",\"extra\":{\"skip\":[1,2,3]}";
+                            out += ",\"city\":\"city" + std::to_string(rng() % 500) + "\"";
+                            out += ",\"zip\":\"" + std::to_string(10000 + rng() % 90000) + "\"";
+                            out += ",\"balance\":" + std::to_string(static_cast<double>(rng() % 10000000) / 100.0);
+                            out += ",\"created\":" + std::to_string(1600000000 + rng() % 100000000);
+                            out += rng() % 4 ? ",\"note\":null}" : ",\"note\":\"vip\"}"; }) +
+               "}";
+    }
+
+    //顶层数组的每个元素单独写成一行
+    std::string to_ndjson(fjson::JsonObject &obj)
+    {
+        std::string out;
+        for (auto &item : obj.get_value<fjson::list_t>())
+        {
+            out += item.to_string();
+            out += '\n';
+        }
+        return out;
+    }
+
+    bool read_file(const std::string &path, std::string &out)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+            return false;
+        std::stringstream ss;
+        ss << in.rdbuf();
+        out = ss.str();
+        return true;
+    }
+
+    //重复运行直到累计时间不少于min_time，吞吐取中位数与最好的一次
+    Result run(const Options &options, const std::string &corpus, const std::string &bench, size_t bytes,
+               const std::function<void()> &body)
+    {
+        body(); //预热，同时让缓冲区达到稳定的大小
+        reset_peak_rss();
+        std::vector<double> seconds;
+        const size_t allocs = g_allocs.load();
+        const size_t alloc_bytes = g_alloc_bytes.load();
+        double total = 0;
+        while (total < options.min_time || seconds.size() < 3)
+        {
+            const auto start = clock_type::now();
+            body();
+            const double elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+            seconds.push_back(elapsed);
+            total += elapsed;
+        }
+
+        Result result;
+        result.corpus = corpus;
+        result.bench = bench;
+        result.bytes = bytes;
+        result.iterations = seconds.size();
+        result.allocs_per_doc = static_cast<double>(g_allocs.load() - allocs) / seconds.size();
+        result.alloc_bytes_per_doc = static_cast<double>(g_alloc_bytes.load() - alloc_bytes) / seconds.size();
+        result.peak_rss_kb = peak_rss_kb();
+        std::sort(seconds.begin(), seconds.end());
+        result.median_mbps = bytes / seconds[seconds.size() / 2] / 1e6;
+        result.best_mbps = bytes / seconds.front() / 1e6;
+        return result;
+    }
+
+    std::vector<Result> run_corpus(const Options &options, const Corpus &corpus)
+    {
+        std::vector<Result> results;
+        const std::string &text = corpus.text;
+        auto keep = [](size_t value)
+        { g_sink.fetch_add(value, std::memory_order_relaxed); };
+
+        results.push_back(run(options, corpus.name, "parse", text.size(), [&]
+                              {
+                                  fjson::JsonObject obj = fjson::Parser::from_string(text);
+                                  keep(obj.get_type()); }));
+        results.push_back(run(options, corpus.name, "parse_arena", text.size(), [&]
+                              {
+                                  fjson::Document doc = fjson::Parser::parse_document(text);
+                                  keep(doc.root().get_type()); }));
+        //零拷贝并驻留键
+        results.push_back(run(options, corpus.name, "parse_zero_copy", text.size(), [&]
+                              {
+                                  fjson::Document doc = fjson::Parser::parse_document(text, true, true);
+                                  keep(doc.root().get_type()); }));
+
+        fjson::JsonObject obj = fjson::Parser::from_string(text);
+        const size_t out_size = obj.to_string().size();
+        results.push_back(run(options, corpus.name, "serialize", out_size, [&]
+                              { keep(obj.to_string().size()); }));
+        fjson::WriteOptions pretty;
+        pretty.pretty = true;
+        const size_t pretty_size = obj.to_string(pretty).size();
+        results.push_back(run(options, corpus.name, "serialize_pretty", pretty_size, [&]
+                              { keep(obj.to_string(pretty).size()); }));
+
+        //不是足够大的数组时parse_parallel退回顺序解析，这里同样计入
+        results.push_back(run(options, corpus.name, "parse_parallel", text.size(), [&]
+                              {
+                                  fjson::JsonObject parsed = fjson::Parser::parse_parallel(text);
+                                  keep(parsed.get_type()); }));
+
+        //建立索引后只取出中间的一个元素（对象则为最后一个成员），包含建立索引的时间
+        const bool is_list = obj.get_type() == fjson::T_LIST;
+        const size_t middle = is_list ? obj.get_value<fjson::list_t>().size() / 2 : 0;
+        std::string last_key;
+        if (obj.get_type() == fjson::T_DICT)
+        {
+            for (auto &member : obj.get_value<fjson::dict_t>())
+                last_key = std::string(member.first);
+        }
+        results.push_back(run(options, corpus.name, "lazy_lookup", text.size(), [&]
+                              {
+                                  fjson::LazyDocument doc(text);
+                                  fjson::LazyValue value = is_list ? doc.root()[middle] : doc.root()[last_key];
+                                  keep(value ? value.materialize().get_type() : 0); }));
+
+        //磁带文件映射后完整转换为JsonObject，按原始文本的大小计算吞吐，便于与parse对比
+        const std::filesystem::path tape_path =
+            std::filesystem::temp_directory_path() / ("fjson_bench_" + corpus.name + ".tape");
+        fjson::Tape::from_json(obj).save(tape_path.string());
+        results.push_back(run(options, corpus.name, "tape_load", text.size(), [&]
+                              {
+                                  fjson::Tape tape = fjson::Tape::load(tape_path.string());
+                                  keep(tape.root().to_json().get_type()); }));
+        std::filesystem::remove(tape_path);
+
+        if (is_list)
+        {
+            const std::string lines = to_ndjson(obj);
+            results.push_back(run(options, corpus.name, "ndjson", lines.size(), [&]
+                                  {
+                                      fjson::NdjsonReader reader{std::string_view(lines)};
+                                      fjson::NdjsonRecord record;
+                                      size_t count = 0;
+                                      while (reader.next(record))
+                                          count++;
+                                      keep(count); }));
+        }
+        return results;
+    }
+
+    //FJSON_FIELDS直接解码，对照先解析为JsonObject再逐个字段读取
+    std::vector<Result> run_dto(const Options &options, const Corpus &corpus)
+    {
+        std::vector<Result> results;
+        const std::string &text = corpus.text;
+        results.push_back(run(options, corpus.name, "decode_fields", text.size(), [&]
+                              {
+                                  DtoPage page = fjson::Parser::FromJSON<DtoPage>(text);
+                                  g_sink.fetch_add(page.items.size(), std::memory_order_relaxed); }));
+        results.push_back(run(options, corpus.name, "decode_dom", text.size(), [&]
+                              {
+                                  fjson::JsonObject obj = fjson::Parser::from_string(text);
+                                  std::vector<Dto> items;
+                                  for (auto &item : obj["items"].get_value<fjson::list_t>())
+                                  {
+                                      Dto dto;
+                                      dto.id = item["id"].get_value<fjson::int_t>();
+                                      dto.name = item["name"].get_value<std::string>();
+                                      dto.email = item["email"].get_value<std::string>();
+                                      dto.age = item["age"].get_value<int>();
+                                      dto.score = item["score"].get_value<fjson::double_t>();
+                                      dto.active = item["active"].get_value<fjson::bool_t>();
+                                      for (auto &tag : item["tags"].get_value<fjson::list_t>())
+                                          dto.tags.push_back(tag.get_value<std::string>());
+                                      dto.city = item["city"].get_value<std::string>();
+                                      dto.zip = item["zip"].get_value<std::string>();
+                                      dto.balance = item["balance"].get_value<fjson::double_t>();
+                                      dto.created = item["created"].get_value<fjson::int_t>();
+                                      if (item["note"].get_type() == fjson::T_STRING)
+                                          dto.note = item["note"].get_value<std::string>();
+                                      items.push_back(std::move(dto));
+                                  }
+                                  g_sink.fetch_add(items.size(), std::memory_order_relaxed); }));
+        return results;
+    }
+
+    std::string to_json(const Result &r)
+    {
+        fjson::Writer writer;
+        writer.start_object();
+        writer.key("corpus");
+        writer.string(r.corpus);
+        writer.key("bench");
+        writer.string(r.bench);
+        writer.key("bytes");
+        writer.unsigned_integer(r.bytes);
+        writer.key("iterations");
+        writer.unsigned_integer(r.iterations);
+        writer.key("median_mbps");
+        writer.number(r.median_mbps);
+        writer.key("best_mbps");
+        writer.number(r.best_mbps);
+        writer.key("allocs_per_doc");
+        writer.number(r.allocs_per_doc);
+        writer.key("alloc_bytes_per_doc");
+        writer.number(r.alloc_bytes_per_doc);
+        writer.key("peak_rss_kb");
+        writer.unsigned_integer(r.peak_rss_kb);
+        writer.end_object();
+        return writer.take();
+    }
+
+    //基线中每项的中位吞吐，键为 语料/测试名
+    std::map<std::string, double> load_baseline(const std::string &path)
+    {
+        std::map<std::string, double> baseline;
+        std::ifstream in(path);
+        if (!in)
+        {
+            std::cerr << "cannot open baseline " << path << "\n";
+            return baseline;
+        }
+        std::string line;
+        while (std::getline(in, line))
+        {
+            if (line.find_first_not_of(" \t\r") == std::string::npos)
+                continue;
+            fjson::JsonObject obj = fjson::Parser::from_string(line);
+            baseline[obj["corpus"].get_value<std::string>() + "/" + obj["bench"].get_value<std::string>()] =
+                obj["median_mbps"].get_value<double>();
+        }
+        return baseline;
+    }
+
+    void print_result(const Result &r, const std::map<std::string, double> &baseline)
+    {
+        char line[256];
+        std::snprintf(line, sizeof(line), "%-14s %-17s %9.1f MB/s (best %7.1f) %10.1f allocs %12.0f B/doc %8zu KB",
+                      r.corpus.c_str(), r.bench.c_str(), r.median_mbps, r.best_mbps, r.allocs_per_doc,
+                      r.alloc_bytes_per_doc, r.peak_rss_kb);
+        std::cerr << line;
+        auto it = baseline.find(r.corpus + "/" + r.bench);
+        if (it != baseline.end() && it->second > 0)
+        {
+            std::snprintf(line, sizeof(line), "  %+6.1f%%", (r.median_mbps / it->second - 1) * 100);
+            std::cerr << line;
+        }
+        std::cerr << "\n";
+    }
+
+    bool parse_args(int argc, char **argv, Options &options)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string arg = argv[i];
+            const bool has_value = i + 1 < argc;
+            if (arg == "--json")
+                options.json = true;
+            else if (arg == "--baseline" && has_value)
+                options.baseline = argv[++i];
+            else if (arg == "--size" && has_value)
+                options.size = static_cast<size_t>(std::atof(argv[++i]) * (1 << 20));
+            else if (arg == "--min-time" && has_value)
+                options.min_time = std::atof(argv[++i]);
+            else if (arg == "--only" && has_value)
+                options.only = argv[++i];
+            else if (arg.compare(0, 2, "--") == 0)
+                return false;
+            else
+                options.files.push_back(arg);
+        }
+        return true;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parse_args(argc, argv, options))
+    {
+        std::cerr << "usage: bench [--json] [--baseline FILE] [--size MB] [--min-time SEC] [--only NAME] [FILE...]\n";
+        return 2;
+    }
+    if (options.files.empty())
+        options.files.push_back("test/test.json");
+
+    std::vector<Corpus> corpora;
+    for (auto &path : options.files)
+    {
+        Corpus corpus;
+        if (!read_file(path, corpus.text))
+        {
+            std::cerr << "cannot read " << path << ", skipped\n";
+            continue;
+        }
+        const size_t slash = path.find_last_of("/\\");
+        corpus.name = slash == std::string::npos ? path : path.substr(slash + 1);
+        corpora.push_back(std::move(corpus));
+    }
+    corpora.push_back({"numbers", gen_numbers(options.size)});
+    corpora.push_back({"strings", gen_strings(options.size)});
+    corpora.push_back({"nested", gen_nested(options.size)});
+    corpora.push_back({"wide", gen_wide(options.size)});
+    corpora.push_back({"dto", gen_dto(options.size)});
+
+    const std::map<std::string, double> baseline =
+        options.baseline.empty() ? std::map<std::string, double>() : load_baseline(options.baseline);
+
+    for (auto &corpus : corpora)
+    {
+        if (!options.only.empty() && corpus.name.find(options.only) == std::string::npos)
+            continue;
+        try
+        {
+            for (auto &result : corpus.name == "dto" ? run_dto(options, corpus) : run_corpus(options, corpus))
+            {
+                print_result(result, baseline);
+                if (options.json)
+                    std::cout << to_json(result) << std::endl;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << corpus.name << ": " << e.what() << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
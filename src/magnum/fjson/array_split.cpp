@@ -0,0 +1,191 @@
+#include "array_split.h"
+#include "../threadpool/threadpool.h"
+
+#include <array>
+#include <cstdint>
+#include <future>
+
+namespace fjson
+{
+    namespace
+    {
+        enum CLASS : uint8_t
+        {
+            C_NONE,
+            C_QUOTE,
+            C_BACKSLASH,
+            C_OPEN,
+            C_CLOSE,
+            C_COMMA,
+            C_SLASH
+        };
+
+        const std::array<uint8_t, 256> k_class = []
+        {
+            std::array<uint8_t, 256> table{};
+            table['"'] = C_QUOTE;
+            table['\\'] = C_BACKSLASH;
+            table['['] = C_OPEN;
+            table['{'] = C_OPEN;
+            table[']'] = C_CLOSE;
+            table['}'] = C_CLOSE;
+            table[','] = C_COMMA;
+            table['/'] = C_SLASH;
+            return table;
+        }();
+
+        inline uint8_t class_of(char ch)
+        {
+            return k_class[static_cast<unsigned char>(ch)];
+        }
+
+        //pos之前连续反斜杠的个数为奇数时，pos处的字符被转义
+        bool escaped_at(std::string_view src, size_t pos)
+        {
+            size_t n = 0;
+            while (n < pos && src[pos - 1 - n] == '\\')
+                n++;
+            return n % 2 == 1;
+        }
+
+        //下标0表示块首在字符串外，1表示块首在字符串内
+        struct ChunkStat
+        {
+            bool odd_quotes = false;
+            long depth[2] = {0, 0};
+            bool slash[2] = {false, false};
+        };
+
+        ChunkStat scan_chunk(std::string_view src, size_t begin, size_t end)
+        {
+            ChunkStat stat;
+            //in为假设0下是否在字符串内，假设1下恰好相反，因此字符串外的字符计入下标in
+            size_t in = 0;
+            size_t i = escaped_at(src, begin) ? begin + 1 : begin;
+            for (; i < end; i++)
+            {
+                switch (class_of(src[i]))
+                {
+                case C_NONE:
+                case C_COMMA:
+                    break;
+                case C_BACKSLASH:
+                    //合法的json中反斜杠只出现在字符串内，跨块时由下一块的escaped_at处理
+                    i++;
+                    break;
+                case C_QUOTE:
+                    in ^= 1;
+                    stat.odd_quotes = !stat.odd_quotes;
+                    break;
+                case C_OPEN:
+                    stat.depth[in]++;
+                    break;
+                case C_CLOSE:
+                    stat.depth[in]--;
+                    break;
+                case C_SLASH:
+                    stat.slash[in] = true;
+                    break;
+                }
+            }
+            return stat;
+        }
+
+        //[begin, end)中第一个位于深度1的逗号，in与depth为begin处的状态
+        size_t find_split(std::string_view src, size_t begin, size_t end, bool in, long depth)
+        {
+            size_t i = escaped_at(src, begin) ? begin + 1 : begin;
+            for (; i < end; i++)
+            {
+                const uint8_t cls = class_of(src[i]);
+                if (cls == C_NONE)
+                    continue;
+                if (cls == C_BACKSLASH)
+                {
+                    i++;
+                    continue;
+                }
+                if (cls == C_QUOTE)
+                {
+                    in = !in;
+                    continue;
+                }
+                if (in)
+                    continue;
+                if (cls == C_OPEN)
+                    depth++;
+                else if (cls == C_CLOSE)
+                    depth--;
+                else if (cls == C_COMMA && depth == 1)
+                    return i;
+            }
+            return std::string_view::npos;
+        }
+    } // namespace
+
+    bool split_top_array(std::string_view src, size_t parts, threadpool::ThreadPool &pool,
+                         std::vector<std::string_view> &ranges)
+    {
+        ranges.clear();
+        if (parts == 0 || src.size() < 2 || src.front() != '[' || src.back() != ']' || pool.in_worker())
+            return false;
+
+        std::vector<size_t> bounds(parts + 1);
+        for (size_t k = 0; k <= parts; k++)
+            bounds[k] = src.size() * k / parts;
+
+        //第一遍：每块在两种假设下的深度变化
+        std::vector<ChunkStat> stats(parts);
+        std::vector<std::future<void>> futures;
+        futures.reserve(parts);
+        for (size_t k = 0; k < parts; k++)
+        {
+            futures.push_back(pool.submit([&, k]
+                                          { stats[k] = scan_chunk(src, bounds[k], bounds[k + 1]); }));
+        }
+        for (auto &f : futures)
+            f.get();
+
+        //顺序累加，确定每块开头是否在字符串内以及所在的深度
+        std::vector<std::pair<bool, long>> starts(parts);
+        bool in = false;
+        long depth = 0;
+        for (size_t k = 0; k < parts; k++)
+        {
+            starts[k] = {in, depth};
+            const size_t h = in ? 1 : 0;
+            if (stats[k].slash[h])
+                return false;
+            depth += stats[k].depth[h];
+            in = in != stats[k].odd_quotes;
+        }
+        if (in || depth != 0)
+            return false;
+
+        //第二遍：每块只在自己的范围内找切分点，每个字节最多扫描一次；
+        //跨越整块的大元素使这一块没有切分点，不会为找逗号扫描到块外
+        std::vector<size_t> splits(parts, std::string_view::npos);
+        futures.clear();
+        for (size_t k = 1; k < parts; k++)
+        {
+            futures.push_back(pool.submit([&, k]
+                                          { splits[k] = find_split(src, bounds[k], bounds[k + 1], starts[k].first,
+                                                                   starts[k].second); }));
+        }
+        for (auto &f : futures)
+            f.get();
+
+        //切分点分属不同的块，天然递增
+        size_t begin = 1;
+        for (size_t k = 1; k < parts; k++)
+        {
+            const size_t split = splits[k];
+            if (split == std::string_view::npos)
+                continue;
+            ranges.push_back(src.substr(begin, split - begin));
+            begin = split + 1;
+        }
+        ranges.push_back(src.substr(begin, src.size() - 1 - begin));
+        return true;
+    }
+} // namespace fjson
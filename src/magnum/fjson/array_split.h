@@ -0,0 +1,32 @@
+#ifndef MAGNUM_FJSON_ARRAY_SPLIT_H__
+#define MAGNUM_FJSON_ARRAY_SPLIT_H__
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace threadpool
+{
+    class ThreadPool;
+} // namespace threadpool
+
+namespace fjson
+{
+    /**
+     * @brief
+     * 把顶层数组切分为若干段连续的元素，供并行解析。
+     * 输入按字节均分为块，第一遍在线程池中并行扫描每一块，同时按"块首在字符串外"与
+     * "块首在字符串内"两种假设统计括号深度的变化（两种假设下的字符串状态恰好互补），
+     * 以及未转义引号个数的奇偶；之后顺序累加即可确定每块开头的真实状态与深度。
+     * 第二遍在每块内部找到第一个位于深度1的逗号作为切分点，块内没有时这一块不切分，
+     * 两遍合计每个字节只扫描两次。
+     *
+     * src首尾不能有空白。返回的每一段都是 "元素,元素,..." 的形式，不含两端的括号和切分用的逗号。
+     * 不是数组、字符串外含有注释或括号不配对时返回false，由调用者退回顺序解析；
+     * 在pool的工作线程上调用时同样返回false，避免等待自己所在线程池的任务。
+     */
+    bool split_top_array(std::string_view src, size_t parts, threadpool::ThreadPool &pool,
+                         std::vector<std::string_view> &ranges);
+} // namespace fjson
+
+#endif //! MAGNUM_FJSON_ARRAY_SPLIT_H__
@@ -0,0 +1,158 @@
+#include "document.h"
+
+#include <algorithm>
+#include <fstream>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define FJSON_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fjson
+{
+    MappedFile::MappedFile(const std::string &path)
+    {
+#ifdef FJSON_HAS_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("open file error: " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("stat file error: " + path);
+        }
+        m_size = static_cast<size_t>(st.st_size);
+        if (m_size == 0) //长度为0的文件无法映射
+        {
+            ::close(fd);
+            return;
+        }
+        void *addr = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED)
+            throw std::runtime_error("mmap file error: " + path);
+        ::madvise(addr, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const char *>(addr);
+        m_mapped = true;
+#else
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in)
+            throw std::runtime_error("open file error: " + path);
+        m_size = static_cast<size_t>(in.tellg());
+        m_fallback.reset(new char[m_size]);
+        in.seekg(0);
+        in.read(m_fallback.get(), m_size);
+        m_data = m_fallback.get();
+#endif
+    }
+
+    MappedFile::~MappedFile()
+    {
+        release();
+    }
+
+    MappedFile::MappedFile(MappedFile &&other) noexcept
+        : m_data(other.m_data), m_size(other.m_size), m_mapped(other.m_mapped),
+          m_fallback(std::move(other.m_fallback))
+    {
+        other.m_data = nullptr;
+        other.m_size = 0;
+        other.m_mapped = false;
+    }
+
+    MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            m_data = other.m_data;
+            m_size = other.m_size;
+            m_mapped = other.m_mapped;
+            m_fallback = std::move(other.m_fallback);
+            other.m_data = nullptr;
+            other.m_size = 0;
+            other.m_mapped = false;
+        }
+        return *this;
+    }
+
+    void MappedFile::release()
+    {
+#ifdef FJSON_HAS_MMAP
+        if (m_mapped)
+            ::munmap(const_cast<char *>(m_data), m_size);
+#endif
+        m_fallback.reset();
+        m_data = nullptr;
+        m_size = 0;
+        m_mapped = false;
+    }
+
+    Document::Document()
+        : m_arena(new std::pmr::monotonic_buffer_resource())
+    {
+        void *mem = m_arena->allocate(sizeof(JsonObject), alignof(JsonObject));
+        m_root = new (mem) JsonObject();
+    }
+
+    Document::Document(MappedFile file)
+        : m_file(std::move(file)),
+          //首块大小按输入长度预估，减少arena向上游申请的次数
+          m_arena(new std::pmr::monotonic_buffer_resource(std::max<size_t>(m_file.view().size(), 1024)))
+    {
+        void *mem = m_arena->allocate(sizeof(JsonObject), alignof(JsonObject));
+        m_root = new (mem) JsonObject();
+    }
+
+    Document::~Document()
+    {
+        release();
+    }
+
+    Document::Document(Document &&other) noexcept
+        : m_file(std::move(other.m_file)), m_arena(std::move(other.m_arena)), m_root(other.m_root),
+          m_keys(std::move(other.m_keys))
+    {
+        other.m_root = nullptr;
+    }
+
+    Document &Document::operator=(Document &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            m_file = std::move(other.m_file);
+            m_arena = std::move(other.m_arena);
+            m_root = other.m_root;
+            m_keys = std::move(other.m_keys);
+            other.m_root = nullptr;
+        }
+        return *this;
+    }
+
+    KeyPool *Document::keys()
+    {
+        if (!m_keys)
+            m_keys.reset(new KeyPool(m_arena.get()));
+        return m_keys.get();
+    }
+
+    void Document::set_root(JsonObject value)
+    {
+        m_root->~JsonObject();
+        new (m_root) JsonObject(std::move(value));
+    }
+
+    void Document::release()
+    {
+        //树的内存全部在arena中，整体释放即可，O(1)且不需要逐个析构节点
+        m_root = nullptr;
+        m_keys.reset();
+        m_arena.reset();
+    }
+} // namespace fjson
\ No newline at end of file
@@ -0,0 +1,94 @@
+#ifndef MAGNUM_FJSON_DOCUMENT_H__
+#define MAGNUM_FJSON_DOCUMENT_H__
+
+#include "json_object.h"
+#include "key_pool.h"
+
+#include <memory>
+
+namespace fjson
+{
+    /**
+     * @brief
+     * 只读映射一个文件，POSIX下使用mmap，其他平台退化为一次性读入
+     */
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::string &path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile &other) = delete;
+        MappedFile &operator=(const MappedFile &other) = delete;
+        MappedFile(MappedFile &&other) noexcept;
+        MappedFile &operator=(MappedFile &&other) noexcept;
+
+        std::string_view view() const
+        {
+            return {m_data, m_size};
+        }
+
+    private:
+        void release();
+
+    private:
+        const char *m_data = nullptr;
+        size_t m_size = 0;
+        bool m_mapped = false;
+        std::unique_ptr<char[]> m_fallback; //无法映射时的自有缓冲区，地址在移动后保持不变
+    };
+
+    /**
+     * @brief
+     * 持有输入缓冲区、一个单调递增的arena，以及在其上解析出的树。
+     * 树的所有节点、字符串和容器都从arena分配，树中借用的字符串与文档同生命周期。
+     * 析构时不遍历树，直接整体释放arena，因此修改树时新建的值也应通过resource()分配，
+     * 否则其占用的堆内存不会被释放。
+     */
+    class Document
+    {
+    public:
+        Document();
+        explicit Document(MappedFile file);
+        ~Document();
+
+        Document(const Document &other) = delete;
+        Document &operator=(const Document &other) = delete;
+        Document(Document &&other) noexcept;
+        Document &operator=(Document &&other) noexcept;
+
+        JsonObject &root()
+        {
+            return *m_root;
+        }
+
+        std::string_view source() const
+        {
+            return m_file.view();
+        }
+
+        std::pmr::memory_resource *resource()
+        {
+            return m_arena.get();
+        }
+
+        //文档自己的键驻留表，第一次调用时在arena上创建
+        KeyPool *keys();
+
+    private:
+        friend class Parser;
+
+        //就地移动构造根节点，保留value原有的分配器
+        void set_root(JsonObject value);
+        void release();
+
+    private:
+        MappedFile m_file;
+        std::unique_ptr<std::pmr::monotonic_buffer_resource> m_arena;
+        JsonObject *m_root = nullptr; //分配在arena中，不调用析构
+        std::unique_ptr<KeyPool> m_keys; //必须先于arena释放
+    };
+} // namespace fjson
+
+#endif //! MAGNUM_FJSON_DOCUMENT_H__
\ No newline at end of file
@@ -0,0 +1,432 @@
+#include "escape.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+namespace fjson
+{
+    namespace
+    {
+        //每个块中满足条件的字节的位图，第i位对应第i个字节
+#if defined(__AVX2__)
+        constexpr size_t k_block = 32;
+        constexpr bool k_exact = true; //位图给出了命中的位置
+
+        inline __m256i load(const char *p)
+        {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        }
+
+        inline uint32_t escape_mask(const char *p)
+        {
+            return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(load(p), _mm256_set1_epi8('\\'))));
+        }
+
+        inline uint32_t unsafe_mask(const char *p)
+        {
+            const __m256i in = load(p);
+            //无符号比较：min(x, 0x1f) == x 即 x < 0x20
+            const __m256i ctrl = _mm256_cmpeq_epi8(_mm256_min_epu8(in, _mm256_set1_epi8(0x1f)), in);
+            const __m256i special = _mm256_or_si256(_mm256_cmpeq_epi8(in, _mm256_set1_epi8('"')),
+                                                    _mm256_cmpeq_epi8(in, _mm256_set1_epi8('\\')));
+            return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(ctrl, special)));
+        }
+
+        inline uint32_t non_ascii_mask(const char *p)
+        {
+            return static_cast<uint32_t>(_mm256_movemask_epi8(load(p)));
+        }
+
+        inline uint32_t text_mask(const char *p)
+        {
+            const __m256i in = load(p);
+            const __m256i ctrl = _mm256_cmpeq_epi8(_mm256_min_epu8(in, _mm256_set1_epi8(0x1f)), in);
+            return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(ctrl, in)));
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        constexpr size_t k_block = 16;
+        constexpr bool k_exact = true;
+
+        inline __m128i load(const char *p)
+        {
+            return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        }
+
+        inline uint32_t escape_mask(const char *p)
+        {
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(load(p), _mm_set1_epi8('\\'))));
+        }
+
+        inline uint32_t unsafe_mask(const char *p)
+        {
+            const __m128i in = load(p);
+            const __m128i ctrl = _mm_cmpeq_epi8(_mm_min_epu8(in, _mm_set1_epi8(0x1f)), in);
+            const __m128i special = _mm_or_si128(_mm_cmpeq_epi8(in, _mm_set1_epi8('"')),
+                                                 _mm_cmpeq_epi8(in, _mm_set1_epi8('\\')));
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(ctrl, special)));
+        }
+
+        inline uint32_t non_ascii_mask(const char *p)
+        {
+            return static_cast<uint32_t>(_mm_movemask_epi8(load(p)));
+        }
+
+        inline uint32_t text_mask(const char *p)
+        {
+            const __m128i in = load(p);
+            const __m128i ctrl = _mm_cmpeq_epi8(_mm_min_epu8(in, _mm_set1_epi8(0x1f)), in);
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(ctrl, in)));
+        }
+#else
+        constexpr size_t k_block = 8;
+        constexpr bool k_exact = false;
+
+        inline uint64_t load(const char *p)
+        {
+            uint64_t word;
+            std::memcpy(&word, p, sizeof(word));
+            return word;
+        }
+
+        //标量实现一次检查8字节，只回答块中是否存在，位置由逐字节扫描确定
+        inline uint32_t has_byte(uint64_t word, uint8_t byte)
+        {
+            const uint64_t x = word ^ (0x0101010101010101ULL * byte);
+            return ((x - 0x0101010101010101ULL) & ~x & 0x8080808080808080ULL) != 0;
+        }
+
+        inline uint32_t escape_mask(const char *p)
+        {
+            return has_byte(load(p), '\\');
+        }
+
+        inline uint32_t unsafe_mask(const char *p)
+        {
+            const uint64_t word = load(p);
+            const uint64_t ctrl = (word - 0x2020202020202020ULL) & ~word & 0x8080808080808080ULL;
+            return ctrl != 0 || has_byte(word, '"') || has_byte(word, '\\');
+        }
+
+        inline uint32_t non_ascii_mask(const char *p)
+        {
+            return (load(p) & 0x8080808080808080ULL) != 0;
+        }
+
+        inline uint32_t text_mask(const char *p)
+        {
+            const uint64_t word = load(p);
+            const uint64_t ctrl = (word - 0x2020202020202020ULL) & ~word & 0x8080808080808080ULL;
+            return ctrl != 0 || (word & 0x8080808080808080ULL) != 0;
+        }
+#endif
+
+        inline bool is_unsafe(unsigned char ch)
+        {
+            return ch < 0x20 || ch == '"' || ch == '\\';
+        }
+
+        inline size_t trailing_zeros(uint32_t bits)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<size_t>(__builtin_ctz(bits));
+#else
+            size_t n = 0;
+            while (!(bits & 1))
+            {
+                bits >>= 1;
+                n++;
+            }
+            return n;
+#endif
+        }
+
+        //整块扫描，标量实现的位图不含位置信息，命中后与尾部一样逐字节确定位置
+        template <class Mask, class Pred>
+        size_t scan(std::string_view src, size_t from, Mask mask, Pred pred)
+        {
+            const char *p = src.data();
+            const size_t n = src.size();
+            for (; from + k_block <= n; from += k_block)
+            {
+                const uint32_t bits = mask(p + from);
+                if (bits == 0)
+                    continue;
+                if constexpr (k_exact)
+                    return from + trailing_zeros(bits);
+                else
+                    break;
+            }
+            for (; from < n; from++)
+            {
+                if (pred(static_cast<unsigned char>(p[from])))
+                    return from;
+            }
+            return std::string_view::npos;
+        }
+
+        inline int hex_value(char ch)
+        {
+            if (ch >= '0' && ch <= '9')
+                return ch - '0';
+            if (ch >= 'a' && ch <= 'f')
+                return ch - 'a' + 10;
+            if (ch >= 'A' && ch <= 'F')
+                return ch - 'A' + 10;
+            return -1;
+        }
+
+        uint32_t read_hex4(std::string_view src, size_t pos)
+        {
+            if (pos + 4 > src.size())
+                throw std::logic_error("invalid unicode escape in string");
+            uint32_t value = 0;
+            for (size_t i = pos; i < pos + 4; i++)
+            {
+                const int digit = hex_value(src[i]);
+                if (digit < 0)
+                    throw std::logic_error("invalid unicode escape in string");
+                value = (value << 4) | static_cast<uint32_t>(digit);
+            }
+            return value;
+        }
+
+        void append_utf8(uint32_t cp, std::string &out)
+        {
+            if (cp < 0x80)
+            {
+                out.push_back(static_cast<char>(cp));
+            }
+            else if (cp < 0x800)
+            {
+                out.push_back(static_cast<char>(0xc0 | (cp >> 6)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+            }
+            else if (cp < 0x10000)
+            {
+                out.push_back(static_cast<char>(0xe0 | (cp >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+            }
+            else
+            {
+                out.push_back(static_cast<char>(0xf0 | (cp >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3f)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+            }
+        }
+
+        //校验从pos开始的一个多字节序列，成功时返回序列长度，失败返回0
+        size_t utf8_sequence(const unsigned char *p, size_t remain)
+        {
+            const unsigned char lead = p[0];
+            size_t len;
+            unsigned char lo = 0x80, hi = 0xbf; //第二个字节的范围
+            if (lead >= 0xc2 && lead <= 0xdf)
+            {
+                len = 2;
+            }
+            else if (lead >= 0xe0 && lead <= 0xef)
+            {
+                len = 3;
+                if (lead == 0xe0)
+                    lo = 0xa0; //过长编码
+                else if (lead == 0xed)
+                    hi = 0x9f; //代理区
+            }
+            else if (lead >= 0xf0 && lead <= 0xf4)
+            {
+                len = 4;
+                if (lead == 0xf0)
+                    lo = 0x90;
+                else if (lead == 0xf4)
+                    hi = 0x8f; //超出U+10FFFF
+            }
+            else
+            {
+                return 0;
+            }
+            if (remain < len || p[1] < lo || p[1] > hi)
+                return 0;
+            for (size_t i = 2; i < len; i++)
+            {
+                if ((p[i] & 0xc0) != 0x80)
+                    return 0;
+            }
+            return len;
+        }
+    } // namespace
+
+    size_t find_escape(std::string_view src, size_t from)
+    {
+        return scan(src, from, escape_mask, [](unsigned char ch)
+                    { return ch == '\\'; });
+    }
+
+    size_t find_unsafe(std::string_view src, size_t from)
+    {
+        return scan(src, from, unsafe_mask, is_unsafe);
+    }
+
+    void unescape(std::string_view src, std::string &out)
+    {
+        size_t pos = 0;
+        while (true)
+        {
+            const size_t esc = find_escape(src, pos);
+            if (esc == std::string_view::npos)
+            {
+                out.append(src.data() + pos, src.size() - pos);
+                return;
+            }
+            out.append(src.data() + pos, esc - pos);
+            if (esc + 1 >= src.size())
+                throw std::logic_error("invalid escape in string");
+            pos = esc + 2;
+            switch (src[esc + 1])
+            {
+            case '"':
+                out.push_back('"');
+                break;
+            case '\\':
+                out.push_back('\\');
+                break;
+            case '/':
+                out.push_back('/');
+                break;
+            case 'b':
+                out.push_back('\b');
+                break;
+            case 'f':
+                out.push_back('\f');
+                break;
+            case 'n':
+                out.push_back('\n');
+                break;
+            case 'r':
+                out.push_back('\r');
+                break;
+            case 't':
+                out.push_back('\t');
+                break;
+            case 'u':
+            {
+                uint32_t cp = read_hex4(src, pos);
+                pos += 4;
+                if (cp >= 0xd800 && cp <= 0xdbff)
+                {
+                    //高代理后面必须紧跟\u形式的低代理
+                    if (pos + 2 > src.size() || src[pos] != '\\' || src[pos + 1] != 'u')
+                        throw std::logic_error("unpaired surrogate in string");
+                    const uint32_t low = read_hex4(src, pos + 2);
+                    if (low < 0xdc00 || low > 0xdfff)
+                        throw std::logic_error("unpaired surrogate in string");
+                    cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+                    pos += 6;
+                }
+                else if (cp >= 0xdc00 && cp <= 0xdfff)
+                {
+                    throw std::logic_error("unpaired surrogate in string");
+                }
+                append_utf8(cp, out);
+                break;
+            }
+            default:
+                throw std::logic_error("invalid escape in string");
+            }
+        }
+    }
+
+    void escape(std::string_view src, std::string &out)
+    {
+        constexpr char hex[] = "0123456789abcdef";
+        size_t pos = 0;
+        while (true)
+        {
+            const size_t i = find_unsafe(src, pos);
+            if (i == std::string_view::npos)
+            {
+                out.append(src.data() + pos, src.size() - pos);
+                return;
+            }
+            out.append(src.data() + pos, i - pos);
+            const unsigned char ch = static_cast<unsigned char>(src[i]);
+            switch (ch)
+            {
+            case '"':
+                out.append("\\\"", 2);
+                break;
+            case '\\':
+                out.append("\\\\", 2);
+                break;
+            case '\b':
+                out.append("\\b", 2);
+                break;
+            case '\f':
+                out.append("\\f", 2);
+                break;
+            case '\n':
+                out.append("\\n", 2);
+                break;
+            case '\r':
+                out.append("\\r", 2);
+                break;
+            case '\t':
+                out.append("\\t", 2);
+                break;
+            default:
+            {
+                const char code[6] = {'\\', 'u', '0', '0', hex[ch >> 4], hex[ch & 0xf]};
+                out.append(code, 6);
+                break;
+            }
+            }
+            pos = i + 1;
+        }
+    }
+
+    bool is_valid_utf8(std::string_view src)
+    {
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(src.data());
+        const size_t n = src.size();
+        size_t pos = 0;
+        while (true)
+        {
+            //跳过纯ASCII的块，只在遇到多字节序列时逐个校验
+            pos = scan(src, pos, non_ascii_mask, [](unsigned char ch)
+                       { return ch >= 0x80; });
+            if (pos == std::string_view::npos)
+                return true;
+            const size_t len = utf8_sequence(p + pos, n - pos);
+            if (len == 0)
+                return false;
+            pos += len;
+        }
+    }
+
+    bool is_valid_string(std::string_view src)
+    {
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(src.data());
+        const size_t n = src.size();
+        size_t pos = 0;
+        while (true)
+        {
+            //控制字符与非ASCII字节在同一次扫描中查找
+            pos = scan(src, pos, text_mask, [](unsigned char ch)
+                       { return ch < 0x20 || ch >= 0x80; });
+            if (pos == std::string_view::npos)
+                return true;
+            if (p[pos] < 0x20)
+                return false;
+            const size_t len = utf8_sequence(p + pos, n - pos);
+            if (len == 0)
+                return false;
+            pos += len;
+        }
+    }
+} // namespace fjson
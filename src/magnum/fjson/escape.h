@@ -0,0 +1,36 @@
+#ifndef MAGNUM_FJSON_ESCAPE_H__
+#define MAGNUM_FJSON_ESCAPE_H__
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace fjson
+{
+    /**
+     * @brief
+     * 字符串的转义与反转义。查找需要处理的字符时每次比较16/32字节，
+     * 没有转义的片段整段拷贝，绝大多数不含转义的字符串只需要一次向量扫描。
+     * 与structural_index相同，编译期根据 __AVX2__ / __SSE2__ 选择实现。
+     */
+
+    //从from开始第一个'\\'的位置，不存在时返回npos
+    size_t find_escape(std::string_view src, size_t from = 0);
+
+    //从from开始第一个输出时需要转义的字符（'"'、'\\'或小于0x20的控制字符），不存在时返回npos
+    size_t find_unsafe(std::string_view src, size_t from = 0);
+
+    //解码引号之间的内容并追加到out，支持\uXXXX与代理对，非法转义抛出std::logic_error
+    void unescape(std::string_view src, std::string &out);
+
+    //转义后追加到out（不含引号），常见控制字符使用短格式，其余为\u00XX
+    void escape(std::string_view src, std::string &out);
+
+    //按RFC 3629校验UTF-8：拒绝过长编码、代理区码点以及超出U+10FFFF的码点
+    bool is_valid_utf8(std::string_view src);
+
+    //引号之间的原始内容是否合法：UTF-8校验同上，并且不含未转义的控制字符（小于0x20）
+    bool is_valid_string(std::string_view src);
+} // namespace fjson
+
+#endif //! MAGNUM_FJSON_ESCAPE_H__
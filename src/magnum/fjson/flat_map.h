@@ -0,0 +1,599 @@
+#ifndef MAGNUM_FJSON_FLAT_MAP_H__
+#define MAGNUM_FJSON_FLAT_MAP_H__
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "key_pool.h"
+
+namespace fjson
+{
+    /**
+     * @brief
+     * json对象的存储：键值对按插入顺序存放在若干个块中，块一旦分配就不再移动，
+     * 因此插入不会使已返回的引用失效（与std::map一致），删除只影响被删除元素及其之后的元素。
+     * 第一块的容量取第一次reserve的大小（解析时正好是成员个数，只有一块），
+     * 之后的块容量按2的幂翻倍，下标到元素的换算只需几次位运算。
+     * 成员不超过k_linear_limit个时直接线性查找，多于这个数目时额外维护一个开放寻址的下标表，
+     * 表中存放元素位置加一（0表示空槽），负载不超过一半。
+     * 删除需要移动后续元素并重建下标表，json对象很少删除键，因此不做优化。
+     * 键带有预先计算的哈希，比较时先比较哈希；键可以借用KeyPool中的驻留字符串，
+     * 此时容器不拷贝也不释放键的内容，KeyPool必须比容器活得久。键是const的，不能通过迭代器修改。
+     * 拷贝容器（例如把文档中的树拷贝出来）时所有键都拷贝为自有的，拷贝结果不依赖KeyPool。
+     * V在声明时可以是不完整类型，成员函数在使用时才实例化。
+     */
+    template <class V>
+    class FlatMap
+    {
+    public:
+        using key_type = Key;
+        using mapped_type = V;
+        using value_type = std::pair<const key_type, V>;
+        using allocator_type = std::pmr::polymorphic_allocator<value_type>;
+
+        //随机访问迭代器，顺序遍历时只移动指针，跨块时才重新定位
+        template <bool Const>
+        class basic_iterator
+        {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = typename FlatMap::value_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = std::conditional_t<Const, const value_type *, value_type *>;
+            using reference = std::conditional_t<Const, const value_type &, value_type &>;
+            using map_pointer = std::conditional_t<Const, const FlatMap *, FlatMap *>;
+
+            basic_iterator() = default;
+            basic_iterator(map_pointer map, size_t index) : m_map(map)
+            {
+                seek(index);
+            }
+            //iterator可以隐式转换为const_iterator
+            template <bool C = Const, class = std::enable_if_t<C>>
+            basic_iterator(const basic_iterator<false> &other)
+                : m_map(other.m_map), m_index(other.m_index), m_ptr(other.m_ptr), m_limit(other.m_limit)
+            {
+            }
+
+            reference operator*() const { return *m_ptr; }
+            pointer operator->() const { return m_ptr; }
+            reference operator[](difference_type n) const { return *m_map->slot(m_index + n); }
+
+            basic_iterator &operator++()
+            {
+                m_index++;
+                if (++m_ptr == m_limit)
+                    seek(m_index);
+                return *this;
+            }
+            basic_iterator operator++(int)
+            {
+                basic_iterator old = *this;
+                ++*this;
+                return old;
+            }
+            basic_iterator &operator--()
+            {
+                seek(m_index - 1);
+                return *this;
+            }
+            basic_iterator operator--(int)
+            {
+                basic_iterator old = *this;
+                --*this;
+                return old;
+            }
+            basic_iterator &operator+=(difference_type n)
+            {
+                seek(m_index + n);
+                return *this;
+            }
+            basic_iterator &operator-=(difference_type n)
+            {
+                seek(m_index - n);
+                return *this;
+            }
+            friend basic_iterator operator+(basic_iterator it, difference_type n) { return it += n; }
+            friend basic_iterator operator+(difference_type n, basic_iterator it) { return it += n; }
+            friend basic_iterator operator-(basic_iterator it, difference_type n) { return it -= n; }
+            friend difference_type operator-(const basic_iterator &a, const basic_iterator &b)
+            {
+                return static_cast<difference_type>(a.m_index) - static_cast<difference_type>(b.m_index);
+            }
+            friend bool operator==(const basic_iterator &a, const basic_iterator &b) { return a.m_index == b.m_index; }
+            friend bool operator!=(const basic_iterator &a, const basic_iterator &b) { return a.m_index != b.m_index; }
+            friend bool operator<(const basic_iterator &a, const basic_iterator &b) { return a.m_index < b.m_index; }
+            friend bool operator>(const basic_iterator &a, const basic_iterator &b) { return a.m_index > b.m_index; }
+            friend bool operator<=(const basic_iterator &a, const basic_iterator &b) { return a.m_index <= b.m_index; }
+            friend bool operator>=(const basic_iterator &a, const basic_iterator &b) { return a.m_index >= b.m_index; }
+
+        private:
+            friend class FlatMap;
+            friend class basic_iterator<!Const>;
+
+            void seek(size_t index)
+            {
+                m_index = index;
+                value_type *limit = nullptr;
+                m_ptr = m_map->locate(index, limit);
+                m_limit = limit;
+            }
+
+            map_pointer m_map = nullptr;
+            size_t m_index = 0;
+            pointer m_ptr = nullptr;
+            pointer m_limit = nullptr; //当前块的末尾
+        };
+
+        using iterator = basic_iterator<false>;
+        using const_iterator = basic_iterator<true>;
+
+        static constexpr size_t k_linear_limit = 8;
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        FlatMap() = default;
+        FlatMap(const allocator_type &alloc) : m_resource(alloc.resource()) {}
+        FlatMap(std::pmr::memory_resource *resource) : m_resource(resource) {}
+
+        //与pmr容器一致，拷贝得到的容器使用默认的memory_resource
+        FlatMap(const FlatMap &other)
+        {
+            copy_from(other);
+        }
+
+        FlatMap(FlatMap &&other) noexcept : m_resource(other.m_resource)
+        {
+            steal(other);
+        }
+
+        FlatMap &operator=(const FlatMap &other)
+        {
+            if (this != &other)
+            {
+                clear();
+                copy_from(other);
+            }
+            return *this;
+        }
+
+        FlatMap &operator=(FlatMap &&other)
+        {
+            if (this == &other)
+                return *this;
+            clear();
+            if (m_resource == other.m_resource)
+            {
+                free_storage();
+                steal(other);
+            }
+            else
+            {
+                //分配器不同时键需要在本容器的resource中重新分配
+                reserve(other.size());
+                for (auto &item : other)
+                    append(item.first.view(), std::move(item.second));
+                other.clear();
+            }
+            return *this;
+        }
+
+        ~FlatMap()
+        {
+            clear();
+            free_storage();
+        }
+
+        allocator_type get_allocator() const
+        {
+            return allocator_type(m_resource);
+        }
+
+        iterator begin() { return iterator(this, 0); }
+        iterator end() { return iterator(this, m_size); }
+        const_iterator begin() const { return const_iterator(this, 0); }
+        const_iterator end() const { return const_iterator(this, m_size); }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        bool empty() const
+        {
+            return m_size == 0;
+        }
+
+        //已分配的块可以容纳的元素个数
+        size_t capacity() const
+        {
+            return m_first_capacity + (((size_t(1) << m_chunk_count) - 1) << m_shift);
+        }
+
+        void reserve(size_t size)
+        {
+            if (size <= capacity())
+                return;
+            if (!m_first)
+            {
+                allocate_first(size);
+                return;
+            }
+            while (capacity() < size)
+                allocate_chunk();
+        }
+
+        //销毁所有元素，保留已分配的块
+        void clear()
+        {
+            for (auto it = begin(); it != end(); ++it)
+            {
+                Key(it->first).deallocate(m_resource);
+                it->~value_type();
+            }
+            m_size = 0;
+            free_slots();
+        }
+
+        //返回键的位置，不存在时返回npos
+        size_t index_of(std::string_view key) const
+        {
+            return index_of(key, Key::hash_of(key));
+        }
+
+        size_t index_of(const Key &key) const
+        {
+            return index_of(key.view(), key.hash());
+        }
+
+        size_t index_of(std::string_view key, uint32_t hash) const
+        {
+            if (!m_slots)
+            {
+                size_t i = 0;
+                for (auto it = begin(); it != end(); ++it, ++i)
+                {
+                    const Key &item = it->first;
+                    if (item.hash() == hash && item.view() == key)
+                        return i;
+                }
+                return npos;
+            }
+            const size_t mask = m_slot_count - 1;
+            for (size_t pos = hash & mask;; pos = (pos + 1) & mask)
+            {
+                const uint32_t index = m_slots[pos];
+                if (index == 0)
+                    return npos;
+                const Key &item = slot(index - 1)->first;
+                if (item.hash() == hash && item.view() == key)
+                    return index - 1;
+            }
+        }
+
+        iterator find(std::string_view key)
+        {
+            const size_t i = index_of(key);
+            return i == npos ? end() : begin() + i;
+        }
+
+        const_iterator find(std::string_view key) const
+        {
+            const size_t i = index_of(key);
+            return i == npos ? end() : begin() + i;
+        }
+
+        size_t count(std::string_view key) const
+        {
+            return index_of(key) == npos ? 0 : 1;
+        }
+
+        bool contains(std::string_view key) const
+        {
+            return index_of(key) != npos;
+        }
+
+        V &at(std::string_view key)
+        {
+            const size_t i = index_of(key);
+            if (i == npos)
+                throw std::out_of_range("key not found in dict");
+            return slot(i)->second;
+        }
+
+        const V &at(std::string_view key) const
+        {
+            const size_t i = index_of(key);
+            if (i == npos)
+                throw std::out_of_range("key not found in dict");
+            return slot(i)->second;
+        }
+
+        //不存在时在末尾插入一个默认值，键使用与容器相同的分配器
+        V &operator[](std::string_view key)
+        {
+            const size_t i = index_of(key);
+            if (i != npos)
+                return slot(i)->second;
+            return append(key)->second;
+        }
+
+        //键已存在时不做修改，返回值的second表示是否插入
+        template <class K, class... Args>
+        std::pair<iterator, bool> try_emplace(K &&key, Args &&...args)
+        {
+            const size_t i = index_of(key);
+            if (i != npos)
+                return {begin() + i, false};
+            return {append(std::forward<K>(key), std::forward<Args>(args)...), true};
+        }
+
+        template <class K, class M>
+        std::pair<iterator, bool> insert_or_assign(K &&key, M &&value)
+        {
+            const size_t i = index_of(key);
+            if (i != npos)
+            {
+                slot(i)->second = std::forward<M>(value);
+                return {begin() + i, false};
+            }
+            return {append(std::forward<K>(key), std::forward<M>(value)), true};
+        }
+
+        template <class K, class M>
+        std::pair<iterator, bool> emplace(K &&key, M &&value)
+        {
+            return try_emplace(std::forward<K>(key), std::forward<M>(value));
+        }
+
+        //之后的元素依次前移，指向它们的引用随之失效
+        iterator erase(const_iterator pos)
+        {
+            const size_t index = pos.m_index;
+            value_type *item = slot(index);
+            Key(item->first).deallocate(m_resource);
+            item->~value_type();
+            for (size_t i = index; i + 1 < m_size; i++)
+            {
+                value_type *next = slot(i + 1);
+                ::new (static_cast<void *>(slot(i))) value_type(next->first, std::move(next->second));
+                next->~value_type();
+            }
+            m_size--;
+            rebuild_index();
+            return begin() + index;
+        }
+
+        size_t erase(std::string_view key)
+        {
+            const size_t i = index_of(key);
+            if (i == npos)
+                return 0;
+            erase(begin() + i);
+            return 1;
+        }
+
+    private:
+        static constexpr size_t k_min_capacity = 4;
+
+        static unsigned floor_log2(size_t value)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<unsigned>(sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(value));
+#else
+            unsigned n = 0;
+            while (value >>= 1)
+                n++;
+            return n;
+#endif
+        }
+
+        //块指针数组的容量：至少4个，之后按2的幂增长
+        static size_t chunk_array_capacity(size_t count)
+        {
+            size_t capacity = 4;
+            while (capacity < count)
+                capacity <<= 1;
+            return capacity;
+        }
+
+        //第i个元素的地址及所在块的末尾，第一块之后的第k块容量为1 << (m_shift + k)；超出容量时返回空指针
+        value_type *locate(size_t i, value_type *&limit) const
+        {
+            if (i < m_first_capacity)
+            {
+                limit = m_first + m_first_capacity;
+                return m_first + i;
+            }
+            if (i >= capacity())
+            {
+                limit = nullptr;
+                return nullptr;
+            }
+            const size_t j = i - m_first_capacity;
+            const unsigned k = floor_log2((j >> m_shift) + 1);
+            limit = m_chunks[k] + (size_t(1) << (m_shift + k));
+            return m_chunks[k] + (j - (((size_t(1) << k) - 1) << m_shift));
+        }
+
+        value_type *slot(size_t i) const
+        {
+            value_type *limit;
+            return locate(i, limit);
+        }
+
+        value_type *allocate_items(size_t count)
+        {
+            return static_cast<value_type *>(m_resource->allocate(count * sizeof(value_type), alignof(value_type)));
+        }
+
+        void allocate_first(size_t count)
+        {
+            m_first = allocate_items(count);
+            m_first_capacity = static_cast<uint32_t>(count);
+            //之后的块从不小于第一块的2的幂开始翻倍
+            m_shift = 0;
+            while ((size_t(1) << m_shift) < count)
+                m_shift++;
+        }
+
+        void allocate_chunk()
+        {
+            const size_t array_capacity = chunk_array_capacity(m_chunk_count);
+            if (!m_chunks || m_chunk_count == array_capacity)
+            {
+                const size_t new_capacity = m_chunks ? array_capacity * 2 : array_capacity;
+                auto chunks = static_cast<value_type **>(m_resource->allocate(new_capacity * sizeof(value_type *), alignof(value_type *)));
+                if (m_chunks)
+                {
+                    std::copy(m_chunks, m_chunks + m_chunk_count, chunks);
+                    m_resource->deallocate(m_chunks, array_capacity * sizeof(value_type *), alignof(value_type *));
+                }
+                m_chunks = chunks;
+            }
+            m_chunks[m_chunk_count] = allocate_items(size_t(1) << (m_shift + m_chunk_count));
+            m_chunk_count++;
+        }
+
+        void free_slots()
+        {
+            if (m_slots)
+                m_resource->deallocate(m_slots, m_slot_count * sizeof(uint32_t), alignof(uint32_t));
+            m_slots = nullptr;
+            m_slot_count = 0;
+        }
+
+        //释放所有块，调用前元素已经销毁
+        void free_storage()
+        {
+            for (size_t k = 0; k < m_chunk_count; k++)
+                m_resource->deallocate(m_chunks[k], (size_t(1) << (m_shift + k)) * sizeof(value_type), alignof(value_type));
+            if (m_chunks)
+                m_resource->deallocate(m_chunks, chunk_array_capacity(m_chunk_count) * sizeof(value_type *), alignof(value_type *));
+            if (m_first)
+                m_resource->deallocate(m_first, m_first_capacity * sizeof(value_type), alignof(value_type));
+            free_slots();
+            m_first = nullptr;
+            m_chunks = nullptr;
+            m_first_capacity = 0;
+            m_shift = 0;
+            m_chunk_count = 0;
+        }
+
+        //接管other的存储，两者的resource必须相同，调用前本容器没有存储
+        void steal(FlatMap &other)
+        {
+            m_first = std::exchange(other.m_first, nullptr);
+            m_chunks = std::exchange(other.m_chunks, nullptr);
+            m_slots = std::exchange(other.m_slots, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+            m_first_capacity = std::exchange(other.m_first_capacity, 0);
+            m_slot_count = std::exchange(other.m_slot_count, 0);
+            m_shift = std::exchange(other.m_shift, 0);
+            m_chunk_count = std::exchange(other.m_chunk_count, 0);
+        }
+
+        //借用的键直接共享，其余的键拷贝到本容器的resource中
+        Key make_key(const Key &key) const
+        {
+            return key.owned() ? Key::allocate(key.view(), key.hash(), m_resource) : key;
+        }
+
+        Key make_key(std::string_view key) const
+        {
+            return Key::allocate(key, Key::hash_of(key), m_resource);
+        }
+
+        void copy_from(const FlatMap &other)
+        {
+            reserve(other.size());
+            for (auto &item : other)
+                append(item.first.view(), item.second);
+        }
+
+        template <class K, class... Args>
+        iterator append(const K &key, Args &&...args)
+        {
+            if (m_size == capacity())
+            {
+                if (!m_first)
+                    allocate_first(k_min_capacity);
+                else
+                    allocate_chunk();
+            }
+            Key stored = make_key(key);
+            try
+            {
+                ::new (static_cast<void *>(slot(m_size))) value_type(std::piecewise_construct, std::forward_as_tuple(stored),
+                                                                      std::forward_as_tuple(std::forward<Args>(args)...));
+            }
+            catch (...)
+            {
+                stored.deallocate(m_resource);
+                throw;
+            }
+            m_size++;
+            if (m_size > k_linear_limit)
+            {
+                if (m_size * 2 > m_slot_count)
+                    rebuild_index();
+                else
+                    insert_slot(m_size - 1);
+            }
+            return iterator(this, m_size - 1);
+        }
+
+        void insert_slot(size_t index)
+        {
+            const size_t mask = m_slot_count - 1;
+            size_t pos = slot(index)->first.hash() & mask;
+            while (m_slots[pos] != 0)
+                pos = (pos + 1) & mask;
+            m_slots[pos] = static_cast<uint32_t>(index + 1);
+        }
+
+        void rebuild_index()
+        {
+            free_slots();
+            if (m_size <= k_linear_limit)
+                return;
+            size_t count = 16;
+            while (count < m_size * 4)
+                count <<= 1;
+            m_slots = static_cast<uint32_t *>(m_resource->allocate(count * sizeof(uint32_t), alignof(uint32_t)));
+            std::fill(m_slots, m_slots + count, 0u);
+            m_slot_count = static_cast<uint32_t>(count);
+            size_t i = 0;
+            for (auto it = begin(); it != end(); ++it, ++i)
+            {
+                const size_t mask = count - 1;
+                size_t pos = it->first.hash() & mask;
+                while (m_slots[pos] != 0)
+                    pos = (pos + 1) & mask;
+                m_slots[pos] = static_cast<uint32_t>(i + 1);
+            }
+        }
+
+    private:
+        value_type *m_first = nullptr;   //第一块
+        value_type **m_chunks = nullptr; //第一块之后的块，容量依次翻倍
+        uint32_t *m_slots = nullptr;     //开放寻址的下标表，为空时使用线性查找
+        std::pmr::memory_resource *m_resource = std::pmr::get_default_resource();
+        uint32_t m_size = 0;
+        uint32_t m_first_capacity = 0;
+        uint32_t m_slot_count = 0;
+        uint8_t m_shift = 0;
+        uint8_t m_chunk_count = 0;
+    };
+} // namespace fjson
+
+#endif //! MAGNUM_FJSON_FLAT_MAP_H__
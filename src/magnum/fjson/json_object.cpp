@@ -1,16 +1,13 @@
 #include "json_object.h"
+#include "writer.h"
+#include "pointer.h"
+
+#include <cstring>
 
 namespace fjson
 {
     JsonObject::JsonObject() //默认为null类型
     {
-        m_type = T_NULL;
-        m_value = "null";
-    }
-
-    JsonObject::JsonObject(int_t value)
-    {
-        JsonObject::Int(value);
     }
 
     JsonObject::JsonObject(bool_t value)
@@ -23,7 +20,22 @@ namespace fjson
         Double(value);
     }
 
-    JsonObject::JsonObject(string_t const &value)
+    JsonObject::JsonObject(const string_t &value)
+    {
+        Str(value);
+    }
+
+    JsonObject::JsonObject(const pmr_string_t &value)
+    {
+        set_string(value, value.get_allocator().resource());
+    }
+
+    JsonObject::JsonObject(std::string_view value)
+    {
+        Str(value);
+    }
+
+    JsonObject::JsonObject(const char *value)
     {
         Str(value);
     }
@@ -38,157 +50,407 @@ namespace fjson
         Dict(std::move(value));
     }
 
+    JsonObject::JsonObject(const JsonObject &other)
+    {
+        copy_from(other);
+    }
+
+    JsonObject::JsonObject(JsonObject &&other) noexcept
+    {
+        steal(other);
+    }
+
+    JsonObject &JsonObject::operator=(const JsonObject &other)
+    {
+        if (this != &other)
+        {
+            //先拷贝再释放，other可能是自己的子节点
+            JsonObject tmp(other);
+            release();
+            steal(tmp);
+        }
+        return *this;
+    }
+
+    JsonObject &JsonObject::operator=(JsonObject &&other) noexcept
+    {
+        if (this != &other)
+        {
+            //other可能是自己的子节点，先取出来再释放
+            JsonObject tmp(std::move(other));
+            release();
+            steal(tmp);
+        }
+        return *this;
+    }
+
+    JsonObject::~JsonObject()
+    {
+        release();
+    }
+
     void JsonObject::Null()
     {
-        m_value = "null";
-        m_type = T_NULL;
+        release();
     }
 
     void JsonObject::Int(int_t value)
     {
-        m_value = value;
-        m_type = T_INT;
+        release();
+        m_int = value;
+        m_tag = T_INT;
+    }
+
+    void JsonObject::UInt(uint_t value)
+    {
+        release();
+        m_uint = value;
+        m_tag = T_UINT;
     }
 
     void JsonObject::Bool(bool_t value)
     {
-        m_value = value;
-        m_type = T_BOOL;
+        release();
+        m_bool = value;
+        m_tag = T_BOOL;
     }
 
     void JsonObject::Double(double_t value)
     {
-        m_type = T_DOUBLE;
-        m_value = value;
+        release();
+        m_double = value;
+        m_tag = T_DOUBLE;
     }
 
-    void JsonObject::Str(std::string_view value)
+    void JsonObject::Str(std::string_view value, std::pmr::memory_resource *resource)
     {
-        m_value = std::string(value);
-        m_type = T_STRING;
+        release();
+        set_string(value, resource);
+    }
+
+    void JsonObject::StrView(str_view_t value)
+    {
+        release();
+        if (value.size() <= k_inline_capacity)
+        {
+            set_string(value, nullptr);
+            return;
+        }
+        if (value.size() > UINT32_MAX)
+            throw std::length_error("string too long in JsonObject");
+        m_str = value.data();
+        m_len = static_cast<uint32_t>(value.size());
+        m_tag = T_STRING | S_VIEW;
     }
 
     void JsonObject::List(list_t value)
     {
-        m_value = std::move(value);
-        m_type = T_LIST;
+        //容器对象与其元素使用同一个resource
+        std::pmr::memory_resource *resource = value.get_allocator().resource();
+        void *mem = resource->allocate(sizeof(list_t), alignof(list_t));
+        list_t *list = new (mem) list_t(std::move(value));
+        release();
+        m_list = list;
+        m_tag = T_LIST;
     }
 
     void JsonObject::Dict(dict_t value)
     {
-        m_value = std::move(value);
-        m_type = T_DICT;
+        std::pmr::memory_resource *resource = value.get_allocator().resource();
+        void *mem = resource->allocate(sizeof(dict_t), alignof(dict_t));
+        dict_t *dict = new (mem) dict_t(std::move(value));
+        release();
+        m_dict = dict;
+        m_tag = T_DICT;
     }
 
-    void *JsonObject::value()
+    void JsonObject::set_string(std::string_view value, std::pmr::memory_resource *resource)
     {
-        switch (this->m_type)
+        //调用前节点必须为null
+        if (value.size() <= k_inline_capacity)
         {
-        case T_NULL:
-            return std::get_if<string_t>(&m_value);
-        case T_BOOL:
-            return std::get_if<bool_t>(&m_value);
-        case T_INT:
-            return std::get_if<int_t>(&m_value);
-        case T_DOUBLE:
-            return std::get_if<double_t>(&m_value);
-        case T_LIST:
-            return std::get_if<list_t>(&m_value);
-        case T_DICT:
-            return std::get_if<dict_t>(&m_value);
-        case T_STRING:
-            return std::get_if<string_t>(&m_value);
-        default:
-            return nullptr;
+            std::memcpy(inline_data(), value.data(), value.size());
+            m_inline_len = static_cast<uint8_t>(value.size());
+            m_tag = T_STRING | S_INLINE;
+            return;
         }
+        if (value.size() > UINT32_MAX)
+            throw std::length_error("string too long in JsonObject");
+        //字符串前面记录分配它的resource，释放时使用
+        char *mem = static_cast<char *>(resource->allocate(sizeof(resource) + value.size(), alignof(void *)));
+        std::memcpy(mem, &resource, sizeof(resource));
+        std::memcpy(mem + sizeof(resource), value.data(), value.size());
+        m_str = mem + sizeof(resource);
+        m_len = static_cast<uint32_t>(value.size());
+        m_tag = T_STRING | S_HEAP;
     }
 
-    JsonObject &JsonObject::operator[](const std::string &key)
+    namespace
     {
-        if (this->m_type == T_DICT)
+        //拷贝中还没有填充的子容器：(null占位的节点, 来源)，只在最外层的拷贝期间有效
+        using CopyPending = std::vector<std::pair<JsonObject *, const JsonObject *>>;
+        thread_local CopyPending *t_copy_pending = nullptr;
+    } // namespace
+
+    void JsonObject::copy_from(const JsonObject &other)
+    {
+        switch (other.m_tag)
         {
-            auto &dict = get_value<dict_t>();
-            return dict[key];
+        case T_LIST:
+        case T_DICT:
+            if (t_copy_pending)
+            {
+                //外层的拷贝正在进行，子容器先留作null，由外层逐个填充，调用栈不随嵌套加深
+                t_copy_pending->push_back({this, &other});
+                break;
+            }
+            copy_nested(other);
+            break;
+        case T_STRING | S_HEAP:
+            set_string(other.get_view(), std::pmr::get_default_resource());
+            break;
+        default:
+            //标量、短字符串与借用的字符串直接复制
+            std::memcpy(static_cast<void *>(this), &other, sizeof(JsonObject));
+            break;
         }
-        throw std::logic_error("not dict type! JsonObject::opertor[]()");
     }
 
-    void JsonObject::push_back(JsonObject item)
+    void JsonObject::copy_nested(const JsonObject &other)
     {
-        if (this->m_type == T_LIST)
+        //容器的拷贝只复制一层，占位的子容器入栈；占位节点已在最终的存储中，之后地址不变
+        auto copy_level = [](JsonObject &dst, const JsonObject &src)
         {
-            auto &list = get_value<list_t>();
-            list.push_back(std::move(item));
-            return;
+            if (src.m_tag == T_LIST)
+                dst.List(*src.m_list);
+            else
+                dst.Dict(*src.m_dict);
+        };
+        CopyPending pending;
+        t_copy_pending = &pending;
+        try
+        {
+            copy_level(*this, other);
+            while (!pending.empty())
+            {
+                auto [dst, src] = pending.back();
+                pending.pop_back();
+                copy_level(*dst, *src);
+            }
         }
-        throw std::logic_error("not a list type! JsonObject::push_back()");
+        catch (...)
+        {
+            //未填充的占位都是null，整棵树可以直接释放
+            t_copy_pending = nullptr;
+            release();
+            throw;
+        }
+        t_copy_pending = nullptr;
     }
 
-#define GET_VALUE(type) *((type *)value)
+    void JsonObject::steal(JsonObject &other)
+    {
+        std::memcpy(static_cast<void *>(this), &other, sizeof(JsonObject));
+        other.m_tag = T_NULL;
+    }
 
-    std::string JsonObject::to_string()
+    namespace
     {
-        void *value = this->value();
-        std::ostringstream os;
-        switch (this->m_type)
+        //浅层直接递归析构，超过这个深度后改为逐层摘下子容器，调用栈的深度因此有上限
+        constexpr size_t k_recursive_release_depth = 64;
+        thread_local size_t t_release_depth = 0;
+
+        inline bool is_nested(JsonObject &obj)
         {
-        case T_NULL:
-            os << "null";
-            break;
-        case T_BOOL:
-            if (GET_VALUE(bool_t))
+            const TYPE type = obj.get_type();
+            return (type == T_LIST && !obj.get_value<list_t>().empty()) ||
+                   (type == T_DICT && !obj.get_value<dict_t>().empty());
+        }
+
+        //把obj中的非空容器移入pending，移走后原位置为null
+        void detach_children(JsonObject &obj, std::vector<JsonObject> &pending)
+        {
+            if (obj.get_type() == T_LIST)
             {
-                os << "true";
+                for (auto &item : obj.get_value<list_t>())
+                {
+                    if (is_nested(item))
+                        pending.push_back(std::move(item));
+                }
             }
-            else
+            else if (obj.get_type() == T_DICT)
             {
-                os << "false";
+                for (auto &item : obj.get_value<dict_t>())
+                {
+                    if (is_nested(item.second))
+                        pending.push_back(std::move(item.second));
+                }
             }
+        }
+    } // namespace
+
+    void JsonObject::release_nested()
+    {
+        std::vector<JsonObject> pending;
+        detach_children(*this, pending);
+        while (!pending.empty())
+        {
+            //node的子容器先被摘下，它自己析构时只剩叶子
+            JsonObject node = std::move(pending.back());
+            pending.pop_back();
+            detach_children(node, pending);
+        }
+    }
+
+    void JsonObject::release()
+    {
+        switch (m_tag)
+        {
+        case T_LIST:
+        {
+            if (t_release_depth >= k_recursive_release_depth)
+                release_nested();
+            std::pmr::memory_resource *resource = m_list->get_allocator().resource();
+            t_release_depth++;
+            m_list->~list_t();
+            t_release_depth--;
+            resource->deallocate(m_list, sizeof(list_t), alignof(list_t));
             break;
-        case T_INT:
-            os << GET_VALUE(int_t);
+        }
+        case T_DICT:
+        {
+            if (t_release_depth >= k_recursive_release_depth)
+                release_nested();
+            std::pmr::memory_resource *resource = m_dict->get_allocator().resource();
+            t_release_depth++;
+            m_dict->~dict_t();
+            t_release_depth--;
+            resource->deallocate(m_dict, sizeof(dict_t), alignof(dict_t));
             break;
-        case T_DOUBLE:
-            os << GET_VALUE(double_t);
+        }
+        case T_STRING | S_HEAP:
+        {
+            std::pmr::memory_resource *resource;
+            char *mem = const_cast<char *>(m_str) - sizeof(resource);
+            std::memcpy(&resource, mem, sizeof(resource));
+            resource->deallocate(mem, sizeof(resource) + m_len, alignof(void *));
             break;
-        case T_STRING:
-            os << '\"' << GET_VALUE(string_t) << '\"';
+        }
+        default:
             break;
-        case T_LIST:
+        }
+        m_tag = T_NULL;
+    }
+
+    str_view_t JsonObject::get_view() const
+    {
+        switch (m_tag)
+        {
+        case T_STRING | S_INLINE:
+            return {inline_data(), m_inline_len};
+        case T_STRING | S_HEAP:
+        case T_STRING | S_VIEW:
+            return {m_str, m_len};
+        default:
+            THROW_GET_ERROR(string);
+        }
+    }
+
+    void JsonObject::materialize(std::pmr::memory_resource *resource)
+    {
+        switch (get_type())
         {
-            list_t list = GET_VALUE(list_t);
-            os << '[';
-            for (auto i = 0; i < list.size(); i++)
+        case T_STRING:
+            if (is_view())
             {
-                if (i != list.size() - 1)
-                {
-                    os << ((list[i]).to_string());
-                    os << ',';
-                }
-                else
-                {
-                    os << ((list[i]).to_string());
-                }
+                str_view_t view = get_view();
+                m_tag = T_NULL;
+                set_string(view, resource);
             }
-            os << ']';
             break;
-        }
+        case T_LIST:
+            for (auto &item : *m_list)
+                item.materialize(resource);
+            break;
         case T_DICT:
+            for (auto &item : *m_dict)
+                item.second.materialize(resource);
+            break;
+        default:
+            break;
+        }
+    }
+
+    JsonObject &JsonObject::operator[](std::string_view key)
+    {
+        if (m_tag == T_DICT)
+        {
+            return get_value<dict_t>()[key];
+        }
+        throw std::logic_error("not dict type! JsonObject::opertor[]()");
+    }
+
+    void JsonObject::push_back(JsonObject item)
+    {
+        if (m_tag == T_LIST)
         {
-            dict_t &dict = GET_VALUE(dict_t);
-            os << '{';
-            for (auto it = dict.begin(); it != dict.end(); ++it)
+            auto &list = get_value<list_t>();
+            list.push_back(std::move(item));
+            return;
+        }
+        throw std::logic_error("not a list type! JsonObject::push_back()");
+    }
+
+    JsonObject *JsonObject::find_pointer(std::string_view pointer)
+    {
+        return find(pointer, true);
+    }
+
+    JsonObject *JsonObject::find_path(std::string_view path)
+    {
+        return find(path, false);
+    }
+
+    JsonObject *JsonObject::find(std::string_view path, bool pointer)
+    {
+        PathCursor cursor(path, pointer);
+        JsonObject *cur = this;
+        std::string_view token;
+        while (cursor.next(token))
+        {
+            if (cur->m_tag == T_DICT)
             {
-                if (it != dict.begin()) //为了保证最后的json格式正确
-                    os << ',';
-                os << '\"' << it->first << "\":" << it->second.to_string();
+                auto it = cur->m_dict->find(token);
+                if (it == cur->m_dict->end())
+                    return nullptr;
+                cur = &it->second;
+            }
+            else if (cur->m_tag == T_LIST)
+            {
+                size_t index;
+                if (!parse_array_index(token, index) || index >= cur->m_list->size())
+                    return nullptr;
+                cur = &(*cur->m_list)[index];
+            }
+            else
+            {
+                return nullptr;
             }
-            os << '}';
-            break;
-        }
-        default:
-            return "";
         }
-        return os.str();
+        return cur;
+    }
+
+    std::string JsonObject::to_string()
+    {
+        return to_string(WriteOptions());
+    }
+
+    std::string JsonObject::to_string(const WriteOptions &options)
+    {
+        //所有层级写入同一块缓冲区，预先按估计的长度分配
+        Writer writer(options);
+        writer.reserve(Writer::estimate_size(*this));
+        writer.write(*this);
+        return writer.take();
     }
 } // namespace fjson
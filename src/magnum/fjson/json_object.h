@@ -3,12 +3,17 @@
 
 #include <stdexcept>
 #include <utility>
-#include <variant>
 #include <map>
 #include <vector>
 #include <string>
 #include <string_view>
 #include <sstream>
+#include <memory_resource>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "flat_map.h"
 
 namespace fjson
 {
@@ -20,18 +25,25 @@ namespace fjson
         T_DOUBLE,
         T_STRING,
         T_LIST,
-        T_DICT
+        T_DICT,
+        T_UINT //超出int64范围的无符号整数
     };
 
     class JsonObject;
+    struct WriteOptions;
 
+    //容器与字符串都通过memory_resource分配，默认使用全局堆，也可以来自Document的arena。
+    //string_t仍是std::string，只用于接口上的取值与构造；节点内部不保存string对象
     using null_t = std::string;
-    using int_t = int32_t;
+    using int_t = int64_t;
+    using uint_t = uint64_t;
     using double_t = double;
     using bool_t = bool;
     using string_t = std::string;
-    using list_t = std::vector<JsonObject>;
-    using dict_t = std::map<std::string, JsonObject>;
+    using pmr_string_t = std::pmr::string; //与arena配合使用的字符串，构造节点时沿用它的resource
+    using list_t = std::pmr::vector<JsonObject>;
+    using dict_t = FlatMap<JsonObject>; //按插入顺序保存成员
+    using str_view_t = std::string_view; //借用外部缓冲区的字符串
 
 #define IS_TYPE(typea, typeb) std::is_same<typea, typeb>::value
 
@@ -39,32 +51,61 @@ namespace fjson
     constexpr bool is_basic_type()
     {
         if constexpr (IS_TYPE(T, string_t) ||
-                      IS_TYPE(T, bool_t) ||
-                      IS_TYPE(T, double_t) ||
-                      IS_TYPE(T, int_t))
+                      IS_TYPE(T, pmr_string_t) ||
+                      std::is_arithmetic<T>::value)
             return true;
 
         return false;
     }
 
+    /**
+     * @brief
+     * 16字节的节点：8字节的值或指针、4字节的长度，最后一个字节是类型标记。
+     * 不超过14字节的字符串直接存放在节点内部；更长的字符串是指针+长度，
+     * 自有的长字符串前面带有分配它的memory_resource，借用的字符串直接指向外部缓冲区；
+     * list和dict对象分配在各自分配器的resource中，节点只保存指针。
+     * 拷贝时与pmr容器一致，拷贝结果使用默认的memory_resource。
+     */
     class JsonObject
     {
     public:
-        using value_t = std::variant<bool_t, int_t, double_t, string_t, list_t, dict_t>;
+        static constexpr size_t k_inline_capacity = 14;
 
         JsonObject();
-        JsonObject(int_t value);
+        //所有整数类型统一到int64，只有超出int64范围的无符号数才存为uint64
+        template <class I, typename std::enable_if<std::is_integral<I>::value && !IS_TYPE(I, bool), int>::type = 0>
+        JsonObject(I value)
+        {
+            if constexpr (std::is_signed<I>::value)
+                Int(value);
+            else if (static_cast<uint_t>(value) <= static_cast<uint_t>(INT64_MAX))
+                Int(static_cast<int_t>(value));
+            else
+                UInt(value);
+        }
         JsonObject(bool_t value);
         JsonObject(double_t value);
         JsonObject(const string_t &value);
+        JsonObject(const pmr_string_t &value);
+        JsonObject(std::string_view value);
+        JsonObject(const char *value);
         JsonObject(list_t value);
         JsonObject(dict_t value);
 
+        JsonObject(const JsonObject &other);
+        JsonObject(JsonObject &&other) noexcept;
+        JsonObject &operator=(const JsonObject &other);
+        JsonObject &operator=(JsonObject &&other) noexcept;
+        ~JsonObject();
+
         void Null();
         void Int(int_t value);
+        void UInt(uint_t value);
         void Bool(bool_t value);
         void Double(double_t value);
-        void Str(std::string_view value);
+        void Str(std::string_view value, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+        // 不拷贝，直接引用外部缓冲区，调用者需保证缓冲区的生命周期；短字符串仍然存放在节点内
+        void StrView(str_view_t value);
         void List(list_t value);
         void Dict(dict_t value);
 
@@ -72,64 +113,178 @@ namespace fjson
 #define THROW_GET_ERROR(erron) throw std::logic_error("type error in get " #erron " value!")
 
         template <class V>
-        V &get_value()
+        decltype(auto) get_value()
         {
-            //添加安全检查
-            if constexpr (IS_TYPE(V, string_t))
+            //字符串没有独立的string对象，只能返回拷贝，不拷贝地读取使用get_view()，修改使用Str()
+            if constexpr (IS_TYPE(V, string_t) || IS_TYPE(V, pmr_string_t))
+            {
+                return V(get_view());
+            }
+            else if constexpr (IS_TYPE(V, str_view_t))
             {
-                if (m_type != T_STRING)
-                    THROW_GET_ERROR(string);
+                return get_view();
             }
-            else if constexpr (IS_TYPE(V, bool_t))
+            //其他宽度的整数按值返回，超出目标类型范围时报错
+            else if constexpr (std::is_integral<V>::value && !IS_TYPE(V, bool_t) &&
+                               !IS_TYPE(V, int_t) && !IS_TYPE(V, uint_t))
+            {
+                return get_integer<V>();
+            }
+            else
+            {
+                return get_value_ref<V>();
+            }
+        }
+
+        TYPE get_type() const
+        {
+            return static_cast<TYPE>(m_tag & k_type_mask);
+        }
+
+        //字符串是否仍然引用着外部缓冲区
+        bool is_view() const
+        {
+            return m_tag == (T_STRING | S_VIEW);
+        }
+
+        //不触发拷贝地读取字符串内容
+        str_view_t get_view() const;
+
+        //把整棵树中借用的字符串拷贝为自有字符串，之后可以脱离原缓冲区使用
+        void materialize(std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+        JsonObject &operator[](std::string_view key);
+        void push_back(JsonObject item);
+
+        //按JSON Pointer（如 /users/17/name）查找，不存在时返回nullptr，不会插入新的键
+        JsonObject *find_pointer(std::string_view pointer);
+        //按点分路径（如 users.17.name）查找，不存在时返回nullptr
+        JsonObject *find_path(std::string_view path);
+        std::string to_string();
+        std::string to_string(const WriteOptions &options);
+
+    private:
+        //标记字节的低4位是类型，高位是字符串的存放方式
+        enum STORAGE : uint8_t
+        {
+            S_INLINE = 0x00,
+            S_HEAP = 0x10,
+            S_VIEW = 0x20
+        };
+        static constexpr uint8_t k_type_mask = 0x0f;
+
+        template <class V>
+        V &get_value_ref()
+        {
+            //添加安全检查
+            if constexpr (IS_TYPE(V, bool_t))
             {
-                if (m_type != T_BOOL)
+                if (m_tag != T_BOOL)
                     THROW_GET_ERROR(BOOL);
+                return m_bool;
             }
             else if constexpr (IS_TYPE(V, int_t))
             {
-                if (m_type != T_INT)
+                if (m_tag != T_INT)
                     THROW_GET_ERROR(INT);
+                return m_int;
+            }
+            else if constexpr (IS_TYPE(V, uint_t))
+            {
+                if (m_tag != T_UINT)
+                    THROW_GET_ERROR(UINT);
+                return m_uint;
             }
             else if constexpr (IS_TYPE(V, double_t))
             {
-                if (m_type != T_DOUBLE)
+                if (m_tag != T_DOUBLE)
                     THROW_GET_ERROR(DOUBLE);
+                return m_double;
             }
             else if constexpr (IS_TYPE(V, list_t))
             {
-                if (m_type != T_LIST)
+                if (m_tag != T_LIST)
                     THROW_GET_ERROR(LIST);
+                return *m_list;
             }
             else if constexpr (IS_TYPE(V, dict_t))
             {
-                if (m_type != T_DICT)
+                if (m_tag != T_DICT)
                     THROW_GET_ERROR(DICT);
+                return *m_dict;
+            }
+            else
+            {
+                static_assert(IS_TYPE(V, dict_t), "unknown type in JsonObject::get_value()");
             }
-
-            void *v = value();
-            if (v == nullptr)
-                throw std::logic_error("unknown type in JsonObject::get_value()");
-            return *((V *)v); //强转即可
         }
 
-        TYPE get_type()
+        template <class V>
+        V get_integer()
         {
-            return m_type;
+            if (m_tag == T_UINT)
+            {
+                if (m_uint > static_cast<uint_t>(std::numeric_limits<V>::max()))
+                    throw std::out_of_range("integer out of range in get value!");
+                return static_cast<V>(m_uint);
+            }
+            if (m_tag != T_INT)
+                THROW_GET_ERROR(INT);
+            int_t value = m_int;
+            if constexpr (std::is_signed<V>::value)
+            {
+                if (value < std::numeric_limits<V>::min() || value > std::numeric_limits<V>::max())
+                    throw std::out_of_range("integer out of range in get value!");
+            }
+            else
+            {
+                if (value < 0 || static_cast<uint_t>(value) > std::numeric_limits<V>::max())
+                    throw std::out_of_range("integer out of range in get value!");
+            }
+            return static_cast<V>(value);
         }
 
-        JsonObject &operator[](const std::string &key);
-        void push_back(JsonObject item);
-        std::string to_string();
+        //短字符串占用节点的前14个字节，长度放在第15个字节
+        char *inline_data()
+        {
+            return reinterpret_cast<char *>(this);
+        }
+        const char *inline_data() const
+        {
+            return reinterpret_cast<const char *>(this);
+        }
 
-    private:
-        //根据类型获取值的地址，直接硬转为void*类型，然后外界调用Value函数进行类型的强转
-        void *value();
+        void set_string(std::string_view value, std::pmr::memory_resource *resource);
+        JsonObject *find(std::string_view path, bool pointer);
+        void copy_from(const JsonObject &other);
+        //拷贝容器：用显式的栈逐层复制，不按嵌套深度递归
+        void copy_nested(const JsonObject &other);
+        //接管other的内容，other变为null
+        void steal(JsonObject &other);
+        //释放自有的内容，之后节点为null
+        void release();
+        //把嵌套的非空容器逐层摘下后再销毁，用于深层的树，避免析构递归过深
+        void release_nested();
 
     private:
-        TYPE m_type;
-        value_t m_value;
+        union
+        {
+            bool_t m_bool;
+            int_t m_int = 0;
+            uint_t m_uint;
+            double_t m_double;
+            const char *m_str; //长字符串
+            list_t *m_list;
+            dict_t *m_dict;
+        };
+        uint32_t m_len = 0; //长字符串的长度
+        uint8_t m_reserved[2] = {};
+        uint8_t m_inline_len = 0;
+        uint8_t m_tag = T_NULL;
     };
 
+    static_assert(sizeof(JsonObject) == 16, "JsonObject should be 16 bytes");
+
 } // namespace fjson
 
 #endif //! MAGNUM_FJSON_JSON_OBJECT_H__
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "key_pool.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace fjson
+{
+    Key Key::allocate(std::string_view str, uint32_t hash, std::pmr::memory_resource *resource)
+    {
+        if (str.size() > k_size_mask)
+            throw std::length_error("json key too long");
+        if (str.empty())
+            return Key();
+        char *data = static_cast<char *>(resource->allocate(str.size(), 1));
+        std::memcpy(data, str.data(), str.size());
+        return Key(data, str.size(), hash, true);
+    }
+
+    void Key::deallocate(std::pmr::memory_resource *resource)
+    {
+        if (owned())
+            resource->deallocate(const_cast<char *>(m_data), size(), 1);
+        *this = Key();
+    }
+
+    KeyPool::KeyPool(std::pmr::memory_resource *upstream)
+        : m_arena(upstream)
+    {
+        m_slots.resize(64, Key(nullptr, 0, 0, false));
+    }
+
+    Key KeyPool::intern(std::string_view key)
+    {
+        return intern(key, Key::hash_of(key));
+    }
+
+    Key KeyPool::intern(std::string_view key, uint32_t hash)
+    {
+        const size_t mask = m_slots.size() - 1;
+        size_t slot = hash & mask;
+        for (; m_slots[slot].m_data != nullptr; slot = (slot + 1) & mask)
+        {
+            const Key &item = m_slots[slot];
+            if (item.m_hash == hash && item.view() == key)
+                return item;
+        }
+
+        if (key.size() > Key::k_size_mask)
+            throw std::length_error("json key too long");
+        char *data = static_cast<char *>(m_arena.allocate(key.size() + 1, 1));
+        std::memcpy(data, key.data(), key.size());
+        data[key.size()] = '\0';
+        Key interned(data, key.size(), hash, false);
+        m_slots[slot] = interned;
+        //负载超过一半时扩容
+        if (++m_size * 2 > m_slots.size())
+            grow();
+        return interned;
+    }
+
+    void KeyPool::grow()
+    {
+        std::vector<Key> slots(m_slots.size() * 2, Key(nullptr, 0, 0, false));
+        const size_t mask = slots.size() - 1;
+        for (const Key &item : m_slots)
+        {
+            if (item.m_data == nullptr)
+                continue;
+            size_t slot = item.m_hash & mask;
+            while (slots[slot].m_data != nullptr)
+                slot = (slot + 1) & mask;
+            slots[slot] = item;
+        }
+        m_slots.swap(slots);
+    }
+} // namespace fjson
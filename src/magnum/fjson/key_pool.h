@@ -0,0 +1,143 @@
+#ifndef MAGNUM_FJSON_KEY_POOL_H__
+#define MAGNUM_FJSON_KEY_POOL_H__
+
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+namespace fjson
+{
+    /**
+     * @brief
+     * 对象的键：指针、长度与预先计算的哈希，共16字节。
+     * 键的内容要么由所在的FlatMap从自己的memory_resource分配（owned），
+     * 要么借用KeyPool中的驻留字符串，此时相同的键共享同一份存储，可以直接比较指针。
+     */
+    class Key
+    {
+    public:
+        Key() = default;
+
+        static uint32_t hash_of(std::string_view str)
+        {
+            const uint64_t hash = std::hash<std::string_view>()(str);
+            return static_cast<uint32_t>(hash ^ (hash >> 32));
+        }
+
+        const char *data() const
+        {
+            return m_data;
+        }
+
+        size_t size() const
+        {
+            return m_size & k_size_mask;
+        }
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        uint32_t hash() const
+        {
+            return m_hash;
+        }
+
+        std::string_view view() const
+        {
+            return {m_data, size()};
+        }
+
+        operator std::string_view() const
+        {
+            return view();
+        }
+
+        //内容是否由所在的容器负责释放
+        bool owned() const
+        {
+            return (m_size & k_owned_bit) != 0;
+        }
+
+        friend bool operator==(const Key &a, const Key &b)
+        {
+            //来自同一个KeyPool的键只需比较指针
+            if (a.m_data == b.m_data && a.size() == b.size())
+                return true;
+            return a.m_hash == b.m_hash && a.view() == b.view();
+        }
+
+        friend bool operator!=(const Key &a, const Key &b)
+        {
+            return !(a == b);
+        }
+
+        friend bool operator==(const Key &a, std::string_view b)
+        {
+            return a.view() == b;
+        }
+
+        friend bool operator!=(const Key &a, std::string_view b)
+        {
+            return a.view() != b;
+        }
+
+    private:
+        template <class V>
+        friend class FlatMap;
+        friend class KeyPool;
+
+        static constexpr uint32_t k_owned_bit = 0x80000000u;
+        static constexpr uint32_t k_size_mask = 0x7fffffffu;
+
+        Key(const char *data, size_t size, uint32_t hash, bool owned)
+            : m_data(data), m_size(static_cast<uint32_t>(size) | (owned ? k_owned_bit : 0)), m_hash(hash)
+        {
+        }
+
+        //从resource分配一份拷贝，由调用者负责释放
+        static Key allocate(std::string_view str, uint32_t hash, std::pmr::memory_resource *resource);
+        void deallocate(std::pmr::memory_resource *resource);
+
+    private:
+        const char *m_data = "";
+        uint32_t m_size = 0; //最高位标记owned
+        uint32_t m_hash = hash_of({});
+    };
+
+    /**
+     * @brief
+     * 键的驻留表，相同内容的键只保存一份，表本身使用开放寻址，比较时先比较预先计算的哈希。
+     * 可以每个文档一个，也可以在多次解析间共享；返回的Key在KeyPool销毁前一直有效。
+     * 不是线程安全的，并行解析时每个线程使用各自的KeyPool。
+     */
+    class KeyPool
+    {
+    public:
+        explicit KeyPool(std::pmr::memory_resource *upstream = std::pmr::get_default_resource());
+        KeyPool(const KeyPool &) = delete;
+        KeyPool &operator=(const KeyPool &) = delete;
+
+        Key intern(std::string_view key);
+        Key intern(std::string_view key, uint32_t hash);
+
+        //已驻留的不同键的数目
+        size_t size() const
+        {
+            return m_size;
+        }
+
+    private:
+        void grow();
+
+    private:
+        std::pmr::monotonic_buffer_resource m_arena;
+        std::vector<Key> m_slots; //data为nullptr表示空槽
+        size_t m_size = 0;
+    };
+} // namespace fjson
+
+#endif //! MAGNUM_FJSON_KEY_POOL_H__
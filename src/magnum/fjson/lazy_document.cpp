@@ -0,0 +1,347 @@
+#include "lazy_document.h"
+#include "parser.h"
+#include "pointer.h"
+#include "escape.h"
+
+#include <cctype>
+#include <cstring>
+
+namespace fjson
+{
+    LazyDocument::LazyDocument(std::string_view src)
+        : m_src(src)
+    {
+        build();
+    }
+
+    LazyDocument::LazyDocument(MappedFile file)
+        : m_file(std::move(file)), m_src(m_file.view())
+    {
+        build();
+    }
+
+    void LazyDocument::build()
+    {
+        if (!is_valid_utf8(m_src))
+            throw std::logic_error("invalid utf-8 in json");
+        if (!build_structural_index(m_src, m_index))
+        {
+            strip_comments();
+            if (!build_structural_index(m_src, m_index))
+                throw std::logic_error("parse string error");
+        }
+        validate();
+    }
+
+    void LazyDocument::strip_comments()
+    {
+        m_stripped.assign(m_src.data(), m_src.size());
+        bool in_string = false;
+        for (size_t i = 0; i < m_stripped.size(); i++)
+        {
+            const char ch = m_stripped[i];
+            if (in_string)
+            {
+                if (ch == '\\')
+                    i++;
+                else if (ch == '"')
+                    in_string = false;
+            }
+            else if (ch == '"')
+            {
+                in_string = true;
+            }
+            else if (ch == '/')
+            {
+                if (i + 1 >= m_stripped.size() || m_stripped[i + 1] != '/')
+                    throw std::logic_error("invalid comment area!");
+                //保留换行，只清除注释内容
+                while (i < m_stripped.size() && m_stripped[i] != '\n')
+                    m_stripped[i++] = ' ';
+            }
+        }
+        m_src = m_stripped;
+    }
+
+    void LazyDocument::check_scalar(uint32_t pos) const
+    {
+        const char *first = m_src.data() + m_index[pos];
+        const char *last = m_src.data() + m_src.size();
+        const char *end = nullptr;
+        const char ch = *first;
+        if (ch == '-' || std::isdigit(ch))
+        {
+            Number num;
+            end = read_number(first, last, num);
+            if (end == nullptr)
+                throw std::logic_error("invalid character in number");
+        }
+        else
+        {
+            for (std::string_view literal : {"true", "false", "null"})
+            {
+                if (static_cast<size_t>(last - first) >= literal.size() &&
+                    std::memcmp(first, literal.data(), literal.size()) == 0)
+                {
+                    end = first + literal.size();
+                    break;
+                }
+            }
+            if (end == nullptr)
+                throw std::logic_error("unexpected character in parse json");
+        }
+        //标量之后紧跟的字符要么是空白，要么是下一个索引项
+        if (end < last && !std::isspace(*end) &&
+            (pos + 1 >= m_index.size() || m_src.data() + m_index[pos + 1] != end))
+            throw std::logic_error("unexpected character in parse json");
+    }
+
+    void LazyDocument::validate()
+    {
+        if (m_index.empty())
+            throw std::logic_error("unexpected character in parse json");
+        m_match.assign(m_index.size(), 0);
+
+        enum STATE
+        {
+            VALUE,
+            KEY,
+            AFTER_VALUE
+        };
+        std::vector<uint32_t> stack; //未闭合的括号
+        const uint32_t n = static_cast<uint32_t>(m_index.size());
+        uint32_t pos = 0;
+        STATE state = VALUE;
+        while (true)
+        {
+            if (state == AFTER_VALUE && stack.empty())
+            {
+                if (pos != n)
+                    throw std::logic_error("unexpected character after json");
+                return;
+            }
+            if (pos >= n)
+                throw std::logic_error("unexpected end in parse json");
+
+            const char ch = at(pos);
+            switch (state)
+            {
+            case VALUE:
+                if (ch == '{' || ch == '[')
+                {
+                    stack.push_back(pos++);
+                    const char close = ch == '{' ? '}' : ']';
+                    if (at(pos) == close)
+                    {
+                        m_match[stack.back()] = pos++;
+                        stack.pop_back();
+                        state = AFTER_VALUE;
+                    }
+                    else
+                    {
+                        state = ch == '{' ? KEY : VALUE;
+                    }
+                }
+                else if (ch == '"')
+                {
+                    //开始引号之后的索引项一定是结束引号
+                    pos += 2;
+                    state = AFTER_VALUE;
+                }
+                else if (ch == '}' || ch == ']' || ch == ':' || ch == ',')
+                {
+                    throw std::logic_error("unexpected character in parse json");
+                }
+                else
+                {
+                    check_scalar(pos++);
+                    state = AFTER_VALUE;
+                }
+                break;
+            case KEY:
+                if (ch != '"')
+                    throw std::logic_error("expected key in parse dict");
+                pos += 2;
+                if (at(pos) != ':')
+                    throw std::logic_error("expected ':' in parse dict");
+                pos++;
+                state = VALUE;
+                break;
+            case AFTER_VALUE:
+            {
+                const bool in_object = at(stack.back()) == '{';
+                if (ch == ',')
+                {
+                    pos++;
+                    state = in_object ? KEY : VALUE;
+                }
+                else if (ch == (in_object ? '}' : ']'))
+                {
+                    m_match[stack.back()] = pos++;
+                    stack.pop_back();
+                }
+                else
+                {
+                    throw std::logic_error(in_object ? "expected ',' in parse dict" : "expected ',' in parse list");
+                }
+                break;
+            }
+            }
+        }
+    }
+
+    size_t LazyDocument::end_offset(uint32_t pos) const
+    {
+        const char ch = at(pos);
+        if (ch == '{' || ch == '[')
+            return m_index[m_match[pos]] + 1;
+        if (ch == '"')
+            return m_index[pos + 1] + 1;
+        //标量结束于下一个索引项或空白之前
+        size_t end = pos + 1 < m_index.size() ? m_index[pos + 1] : m_src.size();
+        while (end > m_index[pos] && std::isspace(m_src[end - 1]))
+            end--;
+        return end;
+    }
+
+    TYPE LazyValue::get_type() const
+    {
+        switch (m_doc->at(m_pos))
+        {
+        case '{':
+            return T_DICT;
+        case '[':
+            return T_LIST;
+        case '"':
+            return T_STRING;
+        case 't':
+        case 'f':
+            return T_BOOL;
+        case 'n':
+            return T_NULL;
+        default:
+        {
+            std::string_view text = raw();
+            Number num;
+            read_number(text.data(), text.data() + text.size(), num);
+            return num.kind == Number::INT ? T_INT : num.kind == Number::UINT ? T_UINT
+                                                                                : T_DOUBLE;
+        }
+        }
+    }
+
+    LazyValue LazyValue::operator[](std::string_view key) const
+    {
+        if (!m_doc || m_doc->at(m_pos) != '{')
+            return {};
+        const auto &index = m_doc->m_index;
+        uint32_t pos = m_pos + 1;
+        std::string decoded; //含转义的键解码后再比较，只有遇到这样的键时才分配
+        //成员依次为：开始引号、结束引号、冒号、值，之后是逗号或右括号
+        while (m_doc->at(pos) == '"')
+        {
+            const size_t begin = index[pos] + 1;
+            std::string_view name = m_doc->m_src.substr(begin, index[pos + 1] - begin);
+            //解码只会让键变短，原文比key短时不可能相等
+            if (name.size() >= key.size() && find_escape(name) != std::string_view::npos)
+            {
+                decoded.clear();
+                unescape(name, decoded);
+                name = decoded;
+            }
+            if (name == key)
+                return LazyValue(m_doc, pos + 3);
+            pos = m_doc->skip(pos + 3);
+            if (m_doc->at(pos) != ',')
+                break;
+            pos++;
+        }
+        return {};
+    }
+
+    LazyValue LazyValue::operator[](size_t i) const
+    {
+        if (!m_doc || m_doc->at(m_pos) != '[' || m_doc->at(m_pos + 1) == ']')
+            return {};
+        uint32_t pos = m_pos + 1;
+        for (; i > 0; i--)
+        {
+            pos = m_doc->skip(pos);
+            if (m_doc->at(pos) != ',')
+                return {};
+            pos++;
+        }
+        return LazyValue(m_doc, pos);
+    }
+
+    size_t LazyValue::size() const
+    {
+        const char ch = m_doc ? m_doc->at(m_pos) : '\0';
+        if (ch != '{' && ch != '[')
+            return 0;
+        if (m_doc->m_match[m_pos] == m_pos + 1)
+            return 0;
+        size_t count = 0;
+        uint32_t pos = m_pos + 1;
+        while (true)
+        {
+            count++;
+            pos = m_doc->skip(ch == '{' ? pos + 3 : pos);
+            if (m_doc->at(pos) != ',')
+                return count;
+            pos++;
+        }
+    }
+
+    LazyValue LazyValue::find_pointer(std::string_view pointer) const
+    {
+        return find(pointer, true);
+    }
+
+    LazyValue LazyValue::find_path(std::string_view path) const
+    {
+        return find(path, false);
+    }
+
+    LazyValue LazyValue::find(std::string_view path, bool pointer) const
+    {
+        PathCursor cursor(path, pointer);
+        LazyValue cur = *this;
+        std::string_view token;
+        while (cur && cursor.next(token))
+        {
+            const char ch = cur.m_doc->at(cur.m_pos);
+            size_t i;
+            if (ch == '{')
+                cur = cur[token];
+            else if (ch == '[' && parse_array_index(token, i))
+                cur = cur[i];
+            else
+                return {};
+        }
+        return cur;
+    }
+
+    std::string_view LazyValue::raw() const
+    {
+        if (!m_doc)
+            return {};
+        const size_t begin = m_doc->m_index[m_pos];
+        return m_doc->m_src.substr(begin, m_doc->end_offset(m_pos) - begin);
+    }
+
+    std::string_view LazyValue::get_view() const
+    {
+        if (!m_doc || m_doc->at(m_pos) != '"')
+            THROW_GET_ERROR(string);
+        std::string_view text = raw();
+        return text.substr(1, text.size() - 2);
+    }
+
+    JsonObject LazyValue::materialize() const
+    {
+        if (!m_doc)
+            return {};
+        return Parser::from_string(raw());
+    }
+} // namespace fjson
@@ -0,0 +1,142 @@
+#ifndef MAGNUM_FJSON_LAZY_DOCUMENT_H__
+#define MAGNUM_FJSON_LAZY_DOCUMENT_H__
+
+#include "json_object.h"
+#include "document.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fjson
+{
+    class LazyDocument;
+
+    /**
+     * @brief
+     * 懒加载文档中一个值的句柄，只记录它在结构索引中的位置，复制代价很小。
+     * 访问成员与元素时沿索引前进，跳过的子树通过预先匹配好的括号一步跳过，
+     * 只有调用materialize()或get_value()时才真正构造JsonObject。
+     * 默认构造或查找失败得到的是空句柄，转换为bool为false。
+     */
+    class LazyValue
+    {
+    public:
+        LazyValue() = default;
+
+        explicit operator bool() const
+        {
+            return m_doc != nullptr;
+        }
+
+        TYPE get_type() const;
+
+        //对象的成员，不存在或不是对象时返回空句柄
+        LazyValue operator[](std::string_view key) const;
+        //数组的元素，越界或不是数组时返回空句柄
+        LazyValue operator[](size_t index) const;
+        //对象的成员数或数组的元素数
+        size_t size() const;
+
+        LazyValue find_pointer(std::string_view pointer) const;
+        LazyValue find_path(std::string_view path) const;
+
+        //值对应的原始json文本
+        std::string_view raw() const;
+        //字符串引号之间的原始内容，不解码转义，需要解码时使用get_value<std::string>()
+        std::string_view get_view() const;
+
+        JsonObject materialize() const;
+
+        template <class V>
+        V get_value() const
+        {
+            return materialize().template get_value<V>();
+        }
+
+    private:
+        friend class LazyDocument;
+
+        LazyValue(const LazyDocument *doc, uint32_t pos) : m_doc(doc), m_pos(pos) {}
+
+        LazyValue find(std::string_view path, bool pointer) const;
+
+    private:
+        const LazyDocument *m_doc = nullptr;
+        uint32_t m_pos = 0; //值的首个字符在结构索引中的位置
+    };
+
+    /**
+     * @brief
+     * 只建立结构索引并校验语法，不构造任何值。校验时同时为每个括号记录匹配的位置，
+     * 因此按路径取少数几个字段的代价接近一次扫描，而不是完整解析。
+     * 借用传入的缓冲区（调用者保证其生命周期），或持有一个映射的文件。
+     * 含有注释时先复制一份并把注释替换为空白，偏移保持不变。
+     */
+    class LazyDocument
+    {
+    public:
+        explicit LazyDocument(std::string_view src);
+        explicit LazyDocument(MappedFile file);
+
+        LazyDocument(const LazyDocument &other) = delete;
+        LazyDocument &operator=(const LazyDocument &other) = delete;
+
+        LazyValue root() const
+        {
+            return LazyValue(this, 0);
+        }
+
+        LazyValue find_pointer(std::string_view pointer) const
+        {
+            return root().find_pointer(pointer);
+        }
+
+        LazyValue find_path(std::string_view path) const
+        {
+            return root().find_path(path);
+        }
+
+        std::string_view source() const
+        {
+            return m_src;
+        }
+
+    private:
+        friend class LazyValue;
+
+        void build();
+        void strip_comments();
+        void validate();
+        void check_scalar(uint32_t pos) const;
+
+        char at(uint32_t pos) const
+        {
+            return pos < m_index.size() ? m_src[m_index[pos]] : '\0';
+        }
+
+        //值之后的第一个索引位置
+        uint32_t skip(uint32_t pos) const
+        {
+            const char ch = at(pos);
+            if (ch == '{' || ch == '[')
+                return m_match[pos] + 1;
+            if (ch == '"')
+                return pos + 2;
+            return pos + 1;
+        }
+
+        //值在源文本中的结束偏移
+        size_t end_offset(uint32_t pos) const;
+
+    private:
+        MappedFile m_file;
+        std::string m_stripped;
+        std::string_view m_src;
+        std::vector<uint32_t> m_index;
+        std::vector<uint32_t> m_match; //开括号对应的闭括号在索引中的位置
+    };
+} // namespace fjson
+
+#endif //! MAGNUM_FJSON_LAZY_DOCUMENT_H__
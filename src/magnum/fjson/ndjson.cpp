@@ -0,0 +1,197 @@
+#include "ndjson.h"
+#include "parser.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace fjson
+{
+    NdjsonReader::NdjsonReader(MappedFile file, NdjsonOptions options)
+        : m_file(std::move(file)), m_input(m_file.view()), m_options(options)
+    {
+        start();
+    }
+
+    NdjsonReader::NdjsonReader(std::string_view buffer, NdjsonOptions options)
+        : m_input(buffer), m_options(options)
+    {
+        start();
+    }
+
+    NdjsonReader::~NdjsonReader()
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            m_stop = true;
+        }
+        m_cond.notify_all();
+        if (m_dispatcher.joinable())
+            m_dispatcher.join();
+        m_pool.reset(); //等待已分发的块处理完
+    }
+
+    void NdjsonReader::start()
+    {
+        if (m_options.threads == 0)
+            m_options.threads = std::max(1u, std::thread::hardware_concurrency());
+        if (m_options.max_inflight == 0)
+            m_options.max_inflight = m_options.threads * 2;
+        if (m_options.chunk_size == 0)
+            m_options.chunk_size = 1;
+        m_pool.reset(new threadpool::ThreadPool(m_options.threads));
+        m_dispatcher = std::thread(&NdjsonReader::dispatch, this);
+    }
+
+    void NdjsonReader::dispatch()
+    {
+        size_t seq = 0;
+        size_t begin = 0;
+        while (begin < m_input.size())
+        {
+            //块的结尾延伸到下一个换行，保证每行完整地落在一个块中
+            size_t end = std::min(begin + m_options.chunk_size, m_input.size());
+            if (end < m_input.size())
+            {
+                const void *nl = std::memchr(m_input.data() + end, '\n', m_input.size() - end);
+                end = nl ? static_cast<const char *>(nl) - m_input.data() + 1 : m_input.size();
+            }
+
+            {
+                std::unique_lock<std::mutex> lk(m_mtx);
+                m_cond.wait(lk, [this]
+                            { return m_stop || m_inflight < m_options.max_inflight; });
+                if (m_stop)
+                    return;
+                m_inflight++;
+            }
+
+            m_pool->submit([this, seq, begin, end]
+                           {
+                               //每个序号都必须交付，否则有序读取会一直等它，分发名额也不会释放
+                               try
+                               {
+                                   Batch batch = parse_chunk(m_input, begin, end);
+                                   batch.seq = seq;
+                                   m_results.push(std::move(batch));
+                               }
+                               catch (const std::exception &e)
+                               {
+                                   m_results.push(failed_chunk(seq, begin, e.what()));
+                               }
+                               catch (...)
+                               {
+                                   m_results.push(failed_chunk(seq, begin, "unknown error"));
+                               } });
+            seq++;
+            begin = end;
+        }
+
+        Batch last;
+        last.seq = seq;
+        last.last = true;
+        m_results.push(std::move(last));
+    }
+
+    NdjsonReader::Batch NdjsonReader::parse_chunk(std::string_view input, size_t begin, size_t end)
+    {
+        Batch batch;
+        Parser parser; //块内各行复用同一个解析器的缓冲区
+        while (begin < end)
+        {
+            const void *nl = std::memchr(input.data() + begin, '\n', end - begin);
+            const size_t line_end = nl ? static_cast<const char *>(nl) - input.data() : end;
+            std::string_view line = input.substr(begin, line_end - begin);
+
+            const size_t first = line.find_first_not_of(" \t\r");
+            if (first != std::string_view::npos)
+            {
+                NdjsonRecord record;
+                record.offset = begin;
+                try
+                {
+                    parser.init(line);
+                    record.value = parser.parse();
+                    if (!parser.done())
+                        throw std::logic_error("unexpected character after json");
+                }
+                catch (const std::exception &e)
+                {
+                    record.value = JsonObject();
+                    record.error = e.what();
+                }
+                batch.records.push_back(std::move(record));
+            }
+            begin = line_end + 1;
+        }
+        return batch;
+    }
+
+    NdjsonReader::Batch NdjsonReader::failed_chunk(size_t seq, size_t begin, const char *what)
+    {
+        Batch batch;
+        batch.seq = seq;
+        NdjsonRecord record;
+        record.offset = begin;
+        record.error = std::string("failed to parse chunk: ") + what;
+        batch.records.push_back(std::move(record));
+        return batch;
+    }
+
+    bool NdjsonReader::fetch_batch()
+    {
+        while (m_next_seq != m_total)
+        {
+            if (m_options.ordered)
+            {
+                auto it = m_pending.find(m_next_seq);
+                if (it != m_pending.end())
+                {
+                    m_current = std::move(it->second);
+                    m_pending.erase(it);
+                    m_next_seq++;
+                    return true;
+                }
+            }
+
+            std::shared_ptr<Batch> batch = m_results.wait_pop();
+            if (batch->last)
+            {
+                m_total = batch->seq;
+                continue;
+            }
+            if (!m_options.ordered || batch->seq == m_next_seq)
+            {
+                m_current = std::move(batch);
+                m_next_seq++; //无序模式下只作为已消费块的计数
+                return true;
+            }
+            m_pending.emplace(batch->seq, std::move(batch));
+        }
+        return false;
+    }
+
+    bool NdjsonReader::next(NdjsonRecord &record)
+    {
+        while (true)
+        {
+            if (m_current)
+            {
+                if (m_current_pos < m_current->records.size())
+                {
+                    record = std::move(m_current->records[m_current_pos++]);
+                    return true;
+                }
+                //当前块消费完毕，释放一个分发名额
+                m_current.reset();
+                m_current_pos = 0;
+                {
+                    std::lock_guard<std::mutex> lk(m_mtx);
+                    m_inflight--;
+                }
+                m_cond.notify_one();
+            }
+            if (!fetch_batch())
+                return false;
+        }
+    }
+} // namespace fjson
\ No newline at end of file
@@ -0,0 +1,100 @@
+#ifndef MAGNUM_FJSON_NDJSON_H__
+#define MAGNUM_FJSON_NDJSON_H__
+
+#include "json_object.h"
+#include "document.h"
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "../threadpool/threadpool.h"
+#include "../threadsafe/queue.h"
+
+namespace fjson
+{
+    struct NdjsonRecord
+    {
+        size_t offset = 0; //行首在输入中的字节偏移
+        JsonObject value;
+        std::string error; //非空表示该行解析失败，不影响其他行
+
+        bool ok() const
+        {
+            return error.empty();
+        }
+    };
+
+    struct NdjsonOptions
+    {
+        size_t threads = 0;          // 0表示使用硬件线程数
+        size_t chunk_size = 1 << 20; //每块的大致字节数，实际会延伸到下一个换行
+        size_t max_inflight = 0;     // 0表示线程数的2倍
+        bool ordered = true;         //是否按输入顺序交付
+    };
+
+    /**
+     * @brief
+     * 并行读取换行分隔的json（NDJSON / JSON Lines）。
+     * 输入按行对齐切分为块，由线程池并行解析，结果以块为单位经threadsafe::Queue交给消费者。
+     * 已分发但尚未被消费完的块数不超过max_inflight，消费慢时分发线程会阻塞等待，内存占用有上限。
+     * 空行会被跳过，每一行单独报告错误；整块处理失败（如内存不足）时，
+     * 该块只交付一条偏移为块首的错误记录，之后的块不受影响。
+     */
+    class NdjsonReader
+    {
+    public:
+        //读取映射的文件，例如 NdjsonReader reader(MappedFile(path));
+        explicit NdjsonReader(MappedFile file, NdjsonOptions options = NdjsonOptions());
+        //读取调用者的缓冲区，调用者需保证其在读取期间有效
+        explicit NdjsonReader(std::string_view buffer, NdjsonOptions options = NdjsonOptions());
+        ~NdjsonReader();
+
+        NdjsonReader(const NdjsonReader &other) = delete;
+        NdjsonReader &operator=(const NdjsonReader &other) = delete;
+
+        //阻塞获取下一条记录，全部读完时返回false
+        bool next(NdjsonRecord &record);
+
+    private:
+        struct Batch
+        {
+            size_t seq = 0;
+            bool last = false; //结束标记，此时seq为总块数
+            std::vector<NdjsonRecord> records;
+        };
+
+        void start();
+        void dispatch();
+        static Batch parse_chunk(std::string_view input, size_t begin, size_t end);
+        //整块处理失败（如内存不足）时用一条错误记录代替该块，偏移为块首
+        static Batch failed_chunk(size_t seq, size_t begin, const char *what);
+        bool fetch_batch();
+
+    private:
+        MappedFile m_file;
+        std::string_view m_input;
+        NdjsonOptions m_options;
+
+        //回压：m_inflight为已分发未消费完的块数
+        std::mutex m_mtx;
+        std::condition_variable m_cond;
+        size_t m_inflight = 0;
+        bool m_stop = false;
+
+        //消费者状态，只在调用next()的线程中访问
+        std::shared_ptr<Batch> m_current;
+        size_t m_current_pos = 0;
+        size_t m_next_seq = 0;
+        size_t m_total = SIZE_MAX;
+        std::map<size_t, std::shared_ptr<Batch>> m_pending; //有序模式下提前到达的块
+
+        threadsafe::Queue<Batch> m_results;
+        std::unique_ptr<threadpool::ThreadPool> m_pool; //先于m_results析构，工作线程退出后队列才销毁
+        std::thread m_dispatcher;
+    };
+} // namespace fjson
+
+#endif //! MAGNUM_FJSON_NDJSON_H__
\ No newline at end of file
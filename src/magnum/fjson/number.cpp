@@ -0,0 +1,149 @@
+#include "number.h"
+
+#include <charconv>
+#include <cmath>
+
+namespace fjson
+{
+    namespace
+    {
+        inline bool is_digit(char ch)
+        {
+            return static_cast<unsigned char>(ch - '0') < 10;
+        }
+
+        //在double中可以精确表示的10的幂
+        constexpr double k_pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+        double slow_double(const char *first, const char *last, bool negative, int64_t exp10)
+        {
+            double value = 0;
+            auto res = std::from_chars(first, last, value);
+            if (res.ec == std::errc::result_out_of_range)
+            {
+                //上溢为无穷，下溢为0
+                value = exp10 > 0 ? HUGE_VAL : 0.0;
+                return negative ? -value : value;
+            }
+            return value;
+        }
+    } // namespace
+
+    const char *read_number(const char *first, const char *last, Number &out)
+    {
+        const char *p = first;
+        const bool negative = p < last && *p == '-';
+        if (negative)
+            ++p;
+
+        // integer part
+        const char *int_begin = p;
+        uint64_t mantissa = 0;
+        if (p == last || !is_digit(*p))
+            return nullptr;
+        if (*p == '0')
+        {
+            ++p;
+        }
+        else
+        {
+            while (p < last && is_digit(*p))
+            {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0'); //超过19位时溢出，此时不再使用
+                ++p;
+            }
+        }
+        size_t digits = p - int_begin;
+
+        // decimal part
+        int64_t exp10 = 0;
+        bool is_integer = true;
+        if (p < last && *p == '.')
+        {
+            ++p;
+            const char *frac_begin = p;
+            while (p < last && is_digit(*p))
+            {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                ++p;
+            }
+            if (p == frac_begin)
+                return nullptr;
+            digits += p - frac_begin;
+            exp10 -= p - frac_begin;
+            is_integer = false;
+        }
+
+        // exponent part
+        if (p < last && (*p == 'e' || *p == 'E'))
+        {
+            ++p;
+            bool exp_negative = false;
+            if (p < last && (*p == '+' || *p == '-'))
+            {
+                exp_negative = *p == '-';
+                ++p;
+            }
+            if (p == last || !is_digit(*p))
+                return nullptr;
+            int64_t exp = 0;
+            while (p < last && is_digit(*p))
+            {
+                if (exp < 1000000) //足够表示任何有意义的double，同时避免溢出
+                    exp = exp * 10 + (*p - '0');
+                ++p;
+            }
+            exp10 += exp_negative ? -exp : exp;
+            is_integer = false;
+        }
+
+        if (is_integer)
+        {
+            if (digits <= 19)
+            {
+                if (!negative && mantissa <= static_cast<uint64_t>(INT64_MAX))
+                {
+                    out.kind = Number::INT;
+                    out.i = static_cast<int64_t>(mantissa);
+                    return p;
+                }
+                if (negative && mantissa <= static_cast<uint64_t>(INT64_MAX) + 1)
+                {
+                    out.kind = Number::INT;
+                    out.i = static_cast<int64_t>(0 - mantissa);
+                    return p;
+                }
+                if (!negative)
+                {
+                    out.kind = Number::UINT;
+                    out.u = mantissa;
+                    return p;
+                }
+            }
+            else if (!negative && digits == 20)
+            {
+                uint64_t value = 0;
+                if (std::from_chars(int_begin, p, value).ec == std::errc())
+                {
+                    out.kind = Number::UINT;
+                    out.u = value;
+                    return p;
+                }
+            }
+            //超出64位整数范围，退化为double
+        }
+
+        out.kind = Number::DOUBLE;
+        if (digits <= 19 && mantissa <= (uint64_t(1) << 53) && exp10 >= -22 && exp10 <= 22)
+        {
+            //尾数与10的幂都能精确表示，一次乘除即为正确舍入的结果
+            double value = static_cast<double>(mantissa);
+            value = exp10 < 0 ? value / k_pow10[-exp10] : value * k_pow10[exp10];
+            out.d = negative ? -value : value;
+            return p;
+        }
+        out.d = slow_double(first, p, negative, exp10);
+        return p;
+    }
+} // namespace fjson
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef MAGNUM_FJSON_NUMBER_H__
+#define MAGNUM_FJSON_NUMBER_H__
+
+#include <cstdint>
+
+namespace fjson
+{
+    /**
+     * @brief
+     * 数字的解析结果：能放进int64的整数为INT，超出int64但能放进uint64的正整数为UINT，
+     * 其余（小数、指数、超出范围的整数）为DOUBLE
+     */
+    struct Number
+    {
+        enum Kind
+        {
+            INT,
+            UINT,
+            DOUBLE
+        };
+
+        Kind kind = INT;
+        union
+        {
+            int64_t i;
+            uint64_t u;
+            double d;
+        };
+    };
+
+    /**
+     * @brief
+     * 按完整的json数字语法 -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)? 单遍解析[first, last)开头的数字，
+     * 返回数字之后的位置，语法错误时返回nullptr。
+     * 有效数字不超过19位时直接使用扫描时累加的尾数（小数走Clinger快速路径），
+     * 否则交给std::from_chars（libstdc++中为Eisel-Lemire算法）。
+     */
+    const char *read_number(const char *first, const char *last, Number &out);
+} // namespace fjson
+
+#endif //! MAGNUM_FJSON_NUMBER_H__
\ No newline at end of file
@@ -1,14 +1,118 @@
 #include "parser.h"
+#include "escape.h"
+#include "array_split.h"
+#include "../threadpool/threadpool.h"
 
 #include <cctype>
 #include <algorithm>
 #include <iostream>
+#include <stdexcept>
 
 namespace fjson
 {
+    std::atomic<size_t> Parser::s_max_depth{Parser::k_default_max_depth};
+
+    void Parser::set_max_depth(size_t depth)
+    {
+        if (depth > k_max_depth_limit)
+            throw std::invalid_argument("max depth exceeds Parser::k_max_depth_limit");
+        s_max_depth.store(depth, std::memory_order_relaxed);
+    }
+
+    size_t Parser::max_depth()
+    {
+        return s_max_depth.load(std::memory_order_relaxed);
+    }
+
+    void Parser::set_depth_limit(size_t depth)
+    {
+        if (depth > k_max_depth_limit)
+            throw std::invalid_argument("max depth exceeds Parser::k_max_depth_limit");
+        m_max_depth = depth;
+    }
+
     JsonObject Parser::parse()
     {
-        char token = get_next_token();
+        //容器通过m_frames展开，嵌套深度不占用调用栈
+        const size_t frame_base = m_frames.size();
+        const size_t elems_base = m_elems.size();
+        const size_t members_base = m_members.size();
+        const size_t keys_base = m_escaped_keys.size();
+        try
+        {
+            while (true)
+            {
+                const char token = get_next_token();
+                const bool open = token == '[' || token == '{';
+                //标量直接构造，避免先默认构造再赋值
+                JsonObject value = open ? JsonObject() : parse_scalar(token);
+                if (open)
+                {
+                    if (m_frames.size() - frame_base >= m_max_depth)
+                    {
+                        throw std::logic_error("json nesting too deep");
+                    }
+                    m_idx++;
+                    const bool dict = token == '{';
+                    m_frames.push_back({dict ? m_members.size() : m_elems.size(), m_escaped_keys.size(), {}, dict});
+                    if (get_next_token() != (dict ? '}' : ']'))
+                    {
+                        if (dict)
+                        {
+                            read_member_key(m_frames.back());
+                        }
+                        continue;
+                    }
+                    m_idx++;
+                    value = finish_container();
+                }
+
+                //值已经完整，放入外层容器；外层也随之结束时继续向上，直到需要读取下一个值
+                while (true)
+                {
+                    if (m_frames.size() == frame_base)
+                    {
+                        return value;
+                    }
+                    Frame &frame = m_frames.back();
+                    if (frame.dict)
+                        m_members.emplace_back(frame.key, std::move(value));
+                    else
+                        m_elems.push_back(std::move(value));
+
+                    const char ch = get_next_token();
+                    if (ch == ',')
+                    {
+                        m_idx++;
+                        if (frame.dict)
+                        {
+                            read_member_key(frame);
+                        }
+                        break;
+                    }
+                    if (ch != (frame.dict ? '}' : ']'))
+                    {
+                        throw std::logic_error(frame.dict ? "expected ',' in parse dict" : "expected ',' in parse list");
+                    }
+                    m_idx++;
+                    value = finish_container();
+                }
+            }
+        }
+        catch (...)
+        {
+            //出错时丢弃暂存的节点。它们可能分配在文档的arena中，必须趁arena还在时释放，
+            //否则下一次init()清理时会访问已经释放的内存
+            m_elems.erase(m_elems.begin() + elems_base, m_elems.end());
+            m_members.erase(m_members.begin() + members_base, m_members.end());
+            m_escaped_keys.resize(keys_base);
+            m_frames.resize(frame_base);
+            throw;
+        }
+    }
+
+    JsonObject Parser::parse_scalar(char token)
+    {
         if (token == 'n')
         {
             return parse_null();
@@ -25,21 +129,40 @@ namespace fjson
         {
             return parse_string();
         }
-        if (token == '[')
-        {
-            return parse_list();
-        }
-        if (token == '{')
+        throw std::logic_error("unexpected character in parse json");
+    }
+
+    bool Parser::done()
+    {
+        while (std::isspace(at(m_idx)))
         {
-            return parse_dict();
+            m_idx++;
         }
-
-        throw std::logic_error("unexpected character in parse json");
+        return m_idx >= m_str.size();
     }
 
     char Parser::get_next_token()
     {
-        while (std::isspace(m_str[m_idx]))
+        if (m_indexed)
+        {
+            //空白之后的第一个字符一定在索引中，直接跳过整段空白
+            if (std::isspace(at(m_idx)))
+            {
+                sync_index();
+                if (m_pos == m_index.size())
+                {
+                    throw std::logic_error("unexpected character in parse json");
+                }
+                m_idx = m_index[m_pos];
+            }
+            if (m_idx >= m_str.size())
+            {
+                throw std::logic_error("unexpected character in parse json");
+            }
+            return m_str[m_idx];
+        }
+
+        while (std::isspace(at(m_idx)))
         {
             m_idx++;
         }
@@ -50,6 +173,10 @@ namespace fjson
         }
 
         skip_comment();
+        if (m_idx >= m_str.size())
+        {
+            throw std::logic_error("unexpected character in parse json");
+        }
         return m_str[m_idx];
     }
 
@@ -78,49 +205,193 @@ namespace fjson
         throw std::logic_error("parse bool error");
     }
 
+    Number Parser::scan_number()
+    {
+        //扫描与转换在同一遍中完成
+        const char *first = m_str.data() + m_idx;
+        Number num;
+        const char *end = read_number(first, m_str.data() + m_str.size(), num);
+        if (end == nullptr)
+        {
+            throw std::logic_error("invalid character in number");
+        }
+        m_idx += end - first;
+        return num;
+    }
+
     JsonObject Parser::parse_number()
     {
-        auto pos = m_idx;
-        // integer part
-        if (m_str[m_idx] == '-')
+        Number num = scan_number();
+        switch (num.kind)
         {
-            m_idx++;
+        case Number::INT:
+            return num.i;
+        case Number::UINT:
+            return num.u;
+        default:
+            return num.d;
         }
-        if (isdigit(m_str[m_idx]))
-            while (isdigit(m_str[m_idx]))
-                m_idx++;
-        else
+    }
+
+    void Parser::expect(char ch)
+    {
+        if (get_next_token() != ch)
         {
-            throw std::logic_error("invalid character in number");
+            throw std::logic_error(std::string("expected '") + ch + "' in parse json");
         }
+        m_idx++;
+    }
 
-        if (m_str[m_idx] != '.')
+    bool Parser::skip_null()
+    {
+        if (get_next_token() != 'n')
         {
-            return (int)strtol(m_str.c_str() + pos, nullptr, 10);
+            return false;
         }
+        parse_null();
+        return true;
+    }
 
-        // decimal part
-        if (m_str[m_idx] == '.')
+    void Parser::skip_value()
+    {
+        char token = get_next_token();
+        if (token == 'n')
+        {
+            parse_null();
+            return;
+        }
+        if (token == 't' || token == 'f')
         {
+            parse_bool();
+            return;
+        }
+        if (token == '-' || std::isdigit(token))
+        {
+            scan_number();
+            return;
+        }
+        if (token == '"')
+        {
+            scan_string();
+            return;
+        }
+        if (token != '[' && token != '{')
+        {
+            throw std::logic_error("unexpected character in parse json");
+        }
+
+        size_t depth = 0;
+        if (m_indexed)
+        {
+            //索引中的括号都在字符串之外，只需数括号即可找到匹配的结尾
+            sync_index();
+            for (; m_pos < m_index.size(); m_pos++)
+            {
+                const char ch = m_str[m_index[m_pos]];
+                if (ch == '[' || ch == '{')
+                {
+                    depth++;
+                }
+                else if ((ch == ']' || ch == '}') && --depth == 0)
+                {
+                    m_idx = m_index[m_pos++] + 1;
+                    return;
+                }
+            }
+            throw std::logic_error("unexpected end in parse json");
+        }
+
+        while (m_idx < m_str.size())
+        {
+            const char ch = m_str[m_idx];
+            if (ch == '"')
+            {
+                scan_string();
+                continue;
+            }
+            if (ch == '/')
+            {
+                const size_t pos = m_idx;
+                skip_comment();
+                if (m_idx == pos)
+                {
+                    throw std::logic_error("unexpected character in parse json");
+                }
+                continue;
+            }
             m_idx++;
-            if (!std::isdigit(m_str[m_idx]))
+            if (ch == '[' || ch == '{')
+            {
+                depth++;
+            }
+            else if ((ch == ']' || ch == '}') && --depth == 0)
             {
-                throw std::logic_error("at least one digit required in parse float part!");
+                return;
             }
-            while (std::isdigit(m_str[m_idx]))
-                m_idx++;
         }
-        return strtod(m_str.c_str() + pos, nullptr);
+        throw std::logic_error("unexpected end in parse json");
+    }
+
+    void Parser::sync_index()
+    {
+        while (m_pos < m_index.size() && m_index[m_pos] < m_idx)
+        {
+            m_pos++;
+        }
     }
 
     JsonObject Parser::parse_string()
     {
+        JsonObject str;
+        std::string_view raw = scan_string();
+        if (find_escape(raw) != std::string_view::npos)
+        {
+            //解码后的内容与输入不同，即使零拷贝也只能分配
+            m_unescaped.clear();
+            unescape(raw, m_unescaped);
+            str.Str(m_unescaped, m_resource);
+        }
+        else if (m_zero_copy)
+            str.StrView(raw);
+        else
+            str.Str(raw, m_resource);
+        return str;
+    }
+
+    std::string_view Parser::read_string()
+    {
+        std::string_view raw = scan_string();
+        if (find_escape(raw) == std::string_view::npos)
+            return raw;
+        m_unescaped.clear();
+        unescape(raw, m_unescaped);
+        return m_unescaped;
+    }
+
+    std::string_view Parser::scan_string()
+    {
+        size_t pos;
+        if (m_indexed)
+        {
+            //开始引号的下一个索引项就是结束引号
+            sync_index();
+            if (m_pos + 1 >= m_index.size() || m_index[m_pos] != m_idx)
+            {
+                throw std::logic_error("parse string error");
+            }
+            pos = m_index[++m_pos];
+            m_pos++;
+        }
+        else
+        {
+            pos = m_str.find('"', m_idx + 1);
+        }
         auto pre_pos = ++m_idx;
-        auto pos = m_str.find('"', m_idx);
         if (pos != std::string::npos)
         {
             //解析还没有结束，需要判断是否是转义的结束符号，如果是转义，则需要继续探查
-            while (true)
+            //索引中的引号已经排除了转义，无需再检查
+            while (!m_indexed)
             {
                 if (m_str[pos - 1] != '\\') //如果不是转义则解析结束
                 {
@@ -138,95 +409,110 @@ namespace fjson
                 }
             }
             m_idx = pos + 1;
-            return m_str.substr(pre_pos, pos - pre_pos);
+            //只校验字符串内容，字符串之外的非法字节由语法检查拒绝
+            std::string_view raw = m_str.substr(pre_pos, pos - pre_pos);
+            if (!is_valid_string(raw))
+                throw std::logic_error("invalid character in string");
+            return raw;
         }
         throw std::logic_error("parse string error");
     }
 
     JsonObject Parser::parse_list()
     {
-        JsonObject arr((list_t()));
-        m_idx++;
-        char ch = get_next_token();
-        if (ch == ']')
+        if (get_next_token() != '[')
         {
-            m_idx++;
-            return arr;
+            throw std::logic_error("expected '[' in parse list");
         }
+        return parse();
+    }
 
-        while (true)
+    JsonObject Parser::parse_dict()
+    {
+        if (get_next_token() != '{')
         {
-            arr.push_back(parse());
-            ch = get_next_token();
-            if (ch == ']')
-            {
-                m_idx++;
-                break;
-            }
-
-            if (ch != ',') //如果不是逗号
-            {
-                throw std::logic_error("expected ',' in parse list");
-            }
-            //跳过逗号
-            m_idx++;
+            throw std::logic_error("expected '{' in parse dict");
         }
-        return arr;
+        return parse();
     }
 
-    JsonObject Parser::parse_dict()
+    void Parser::read_member_key(Frame &frame)
     {
-        JsonObject dict((dict_t()));
-        m_idx++;
-        char ch = get_next_token();
-        if (ch == '}')
+        if (get_next_token() != '"')
         {
-            m_idx++;
-            return dict;
+            throw std::logic_error("expected key in parse dict");
         }
+        std::string_view key = scan_string();
+        if (find_escape(key) != std::string_view::npos)
+        {
+            //暂存的键要保留到对象结束，不能使用共享的m_unescaped
+            std::string &decoded = m_escaped_keys.emplace_back();
+            unescape(key, decoded);
+            key = decoded;
+        }
+        if (get_next_token() != ':')
+        {
+            throw std::logic_error("expected ':' in parse dict");
+        }
+        m_idx++;
+        frame.key = key;
+    }
 
-        while (true)
+    JsonObject Parser::finish_container()
+    {
+        //元素与成员先暂存，结束后按准确大小一次性分配，避免容器反复扩容
+        const Frame frame = m_frames.back();
+        m_frames.pop_back();
+        if (!frame.dict)
         {
-            //解析key
-            string_t key = std::move(parse().get_value<string_t>());
-            ch = get_next_token();
-            if (ch != ':')
+            list_t list(m_resource);
+            list.reserve(m_elems.size() - frame.base);
+            for (size_t i = frame.base; i < m_elems.size(); i++)
             {
-                throw std::logic_error("expected ':' in parse dict");
+                list.push_back(std::move(m_elems[i]));
             }
-            m_idx++;
+            m_elems.erase(m_elems.begin() + frame.base, m_elems.end());
+            return list;
+        }
 
-            //解析value
-            dict[key] = parse();
-            ch = get_next_token();
-            if (ch == '}')
-            {
-                m_idx++;
-                break; //解析完毕
-            }
-            if (ch != ',') //没有结束，此时必须为逗号
-            {
-                throw std::logic_error("expected ',' in parse dict");
-            }
-            //跳过逗号
-            m_idx++;
+        //重复的key以后出现的为准
+        dict_t dict(m_resource);
+        dict.reserve(m_members.size() - frame.base);
+        for (size_t i = frame.base; i < m_members.size(); i++)
+        {
+            if (m_keys)
+                dict.insert_or_assign(m_keys->intern(m_members[i].first), std::move(m_members[i].second));
+            else
+                dict.insert_or_assign(m_members[i].first, std::move(m_members[i].second));
         }
+        m_members.erase(m_members.begin() + frame.base, m_members.end());
+        m_escaped_keys.resize(frame.key_base);
         return dict;
     }
 
-    void Parser::init(std::string_view src)
+    void Parser::init(std::string_view src, bool zero_copy, std::pmr::memory_resource *resource, KeyPool *keys)
     {
         m_str = src;
         m_idx = 0;
+        m_zero_copy = zero_copy;
+        m_resource = resource ? resource : std::pmr::get_default_resource();
+        m_keys = keys;
+        m_elems.clear();
+        m_members.clear();
+        m_escaped_keys.clear();
+        m_frames.clear();
+        m_max_depth = max_depth();
         trim_right();
+        m_pos = 0;
+        m_indexed = build_structural_index(m_str, m_index);
     }
 
     void Parser::trim_right()
     {
-        m_str.erase(std::find_if(m_str.rbegin(), m_str.rend(), [](char ch)
-                                 { return !std::isspace(ch); })
-                        .base(),
-                    m_str.end());
+        //只收缩视图，不修改调用者的缓冲区
+        auto last = std::find_if(m_str.rbegin(), m_str.rend(), [](char ch)
+                                 { return !std::isspace(ch); });
+        m_str.remove_suffix(last - m_str.rbegin());
     }
 
     void Parser::skip_comment()
@@ -242,7 +528,7 @@ namespace fjson
                 }
                 //查看下一行是否还是注释
                 m_idx = next_pos + 1;
-                while (isspace(m_str[m_idx]))
+                while (isspace(at(m_idx)))
                 {
                     m_idx++;
                 }
@@ -254,11 +540,212 @@ namespace fjson
         }
     }
 
-    JsonObject Parser::from_string(std::string_view content)
+    Parser &Parser::instance()
+    {
+        thread_local Parser instance;
+        return instance;
+    }
+
+    JsonObject Parser::from_string(std::string_view content, KeyPool *keys)
+    {
+        Parser &parser = instance();
+        parser.init(content, false, nullptr, keys);
+        return parser.parse();
+    }
+
+    JsonObject Parser::from_buffer(std::string_view buffer)
+    {
+        Parser &parser = instance();
+        parser.init(buffer, true);
+        return parser.parse();
+    }
+
+    Document Parser::from_file(const std::string &path)
+    {
+        Document doc{MappedFile(path)};
+        Parser &parser = instance();
+        parser.init(doc.source(), true, doc.resource());
+        doc.set_root(parser.parse());
+        return doc;
+    }
+
+    Document Parser::parse_document(std::string_view content, bool zero_copy, bool intern_keys)
+    {
+        Document doc;
+        Parser &parser = instance();
+        parser.init(content, zero_copy, doc.resource(), intern_keys ? doc.keys() : nullptr);
+        doc.set_root(parser.parse());
+        return doc;
+    }
+
+    namespace
+    {
+        //小于这个大小的输入切分的收益抵不上调度的开销
+        constexpr size_t k_parallel_threshold = 1 << 20;
+
+        threadpool::ThreadPool &default_pool()
+        {
+            static threadpool::ThreadPool pool;
+            return pool;
+        }
+
+        //等待全部任务结束后再取结果，避免出错返回时仍有任务在写共享的数据
+        void wait_all(std::vector<std::future<void>> &futures)
+        {
+            for (auto &f : futures)
+                f.wait();
+            for (auto &f : futures)
+                f.get();
+        }
+    } // namespace
+
+    std::vector<JsonObject> Parser::parse_many(const std::vector<std::string_view> &docs)
+    {
+        if (docs.size() < 2)
+        {
+            std::vector<JsonObject> results;
+            for (auto doc : docs)
+                results.push_back(from_string(doc));
+            return results;
+        }
+        return parse_many(docs, default_pool());
+    }
+
+    std::vector<JsonObject> Parser::parse_many(const std::vector<std::string_view> &docs, threadpool::ThreadPool &pool)
     {
-        static Parser instance;
-        instance.init(content);
-        return instance.parse();
+        std::vector<JsonObject> results(docs.size());
+        if (pool.in_worker())
+        {
+            for (size_t i = 0; i < docs.size(); i++)
+                results[i] = from_string(docs[i]);
+            return results;
+        }
+        //每个任务负责一段连续的文档，任务数取线程数的若干倍以平衡负载
+        const size_t tasks = std::min(docs.size(), pool.size() * 4);
+        std::vector<std::future<void>> futures;
+        futures.reserve(tasks);
+        for (size_t t = 0; t < tasks; t++)
+        {
+            const size_t begin = docs.size() * t / tasks;
+            const size_t end = docs.size() * (t + 1) / tasks;
+            futures.push_back(pool.submit([&docs, &results, begin, end]
+                                          {
+                                              for (size_t i = begin; i < end; i++)
+                                                  results[i] = from_string(docs[i]); }));
+        }
+        wait_all(futures);
+        return results;
+    }
+
+    JsonObject Parser::parse_parallel(std::string_view content)
+    {
+        if (content.size() < k_parallel_threshold)
+            return from_string(content);
+        return parse_parallel(content, default_pool());
+    }
+
+    JsonObject Parser::parse_parallel(std::string_view content, threadpool::ThreadPool &pool)
+    {
+        const size_t first = content.find_first_not_of(" \t\n\v\f\r");
+        const size_t last = content.find_last_not_of(" \t\n\v\f\r");
+        std::vector<std::string_view> ranges;
+        //只切出一段（如只含空白的数组）时没有可并行的部分，空白段也不能单独解析
+        if (content.size() < k_parallel_threshold || pool.size() < 2 || pool.in_worker() ||
+            first == std::string_view::npos ||
+            !split_top_array(content.substr(first, last - first + 1), pool.size() * 4, pool, ranges) ||
+            ranges.size() < 2)
+        {
+            return from_string(content);
+        }
+
+        //每段在所在线程的解析器上解析，元素暂存后按段的顺序拼接
+        std::vector<std::vector<JsonObject>> parts(ranges.size());
+        std::vector<std::future<void>> futures;
+        futures.reserve(ranges.size());
+        for (size_t i = 0; i < ranges.size(); i++)
+        {
+            futures.push_back(pool.submit([&ranges, &parts, i]
+                                          {
+                                              Parser &parser = instance();
+                                              parser.init(ranges[i]);
+                                              //元素位于顶层数组之内，深度从1开始，与顺序解析的上限一致
+                                              const size_t limit = parser.depth_limit();
+                                              if (limit == 0)
+                                                  throw std::logic_error("json nesting too deep");
+                                              parser.set_depth_limit(limit - 1);
+                                              while (true)
+                                              {
+                                                  parts[i].push_back(parser.parse());
+                                                  if (parser.done())
+                                                      break;
+                                                  parser.expect(',');
+                                              } }));
+        }
+        wait_all(futures);
+
+        size_t total = 0;
+        for (auto &part : parts)
+            total += part.size();
+        list_t list;
+        list.reserve(total);
+        for (auto &part : parts)
+        {
+            for (auto &item : part)
+                list.push_back(std::move(item));
+        }
+        return list;
+    }
+
+    std::string Parser::to_string_parallel(JsonObject &obj, const WriteOptions &options)
+    {
+        return to_string_parallel(obj, default_pool(), options);
+    }
+
+    std::string Parser::to_string_parallel(JsonObject &obj, threadpool::ThreadPool &pool, const WriteOptions &options)
+    {
+        const size_t count = obj.get_type() == T_LIST ? obj.get_value<list_t>().size() : 0;
+        const size_t tasks = std::min(count, pool.size() * 4);
+        if (tasks < 2 || pool.in_worker())
+            return obj.to_string(options);
+
+        //每段写成一个完整的数组，再去掉两端的括号拼接，缩进与整体写出时相同
+        auto &list = obj.get_value<list_t>();
+        std::vector<std::string> parts(tasks);
+        std::vector<std::future<void>> futures;
+        futures.reserve(tasks);
+        for (size_t t = 0; t < tasks; t++)
+        {
+            const size_t begin = count * t / tasks;
+            const size_t end = count * (t + 1) / tasks;
+            futures.push_back(pool.submit([&list, &parts, &options, t, begin, end]
+                                          {
+                                              Writer writer(options);
+                                              writer.start_array();
+                                              for (size_t i = begin; i < end; i++)
+                                                  writer.write(list[i]);
+                                              writer.end_array();
+                                              parts[t] = writer.take(); }));
+        }
+        wait_all(futures);
+
+        //非空数组在pretty模式下以换行加']'结尾
+        const size_t tail = options.pretty ? 2 : 1;
+        size_t size = 2 + tasks;
+        for (auto &part : parts)
+            size += part.size() - 1 - tail;
+        std::string out;
+        out.reserve(size);
+        out.push_back('[');
+        for (size_t t = 0; t < tasks; t++)
+        {
+            if (t > 0)
+                out.push_back(',');
+            out.append(parts[t], 1, parts[t].size() - 1 - tail);
+        }
+        if (options.pretty)
+            out.push_back('\n');
+        out.push_back(']');
+        return out;
     }
 
     bool Parser::is_esc_consume(size_t pos)
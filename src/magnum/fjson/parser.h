@@ -2,6 +2,18 @@
 #define MAGNUM_FJSON_PARSER_H__
 
 #include "json_object.h"
+#include "document.h"
+#include "structural_index.h"
+#include "number.h"
+#include "reflect.h"
+
+#include <atomic>
+#include <deque>
+
+namespace threadpool
+{
+    class ThreadPool;
+} // namespace threadpool
 
 namespace fjson
 {
@@ -31,73 +43,386 @@ namespace fjson
     public:
         Parser() = default;
 
-        void init(std::string_view src);
+        // zero_copy为true时字符串值直接引用src，不做拷贝；
+        // resource为空时使用全局堆，否则所有节点都从resource分配；
+        // keys不为空时对象的键驻留在keys中，相同的键共享存储，keys需比解析结果活得久
+        void init(std::string_view src, bool zero_copy = false, std::pmr::memory_resource *resource = nullptr,
+                  KeyPool *keys = nullptr);
+
+        //嵌套深度的上限，超过时抛出异常。set_max_depth设置的是进程内的默认值，每次init时取用
+        static constexpr size_t k_default_max_depth = 1024;
+        //深度上限允许的最大值。解析与拷贝不递归，但序列化等仍按层递归，
+        //这个值在默认8MB栈上留有足够余量；超过它时设置函数抛出std::invalid_argument
+        static constexpr size_t k_max_depth_limit = 10000;
+        static void set_max_depth(size_t depth);
+        static size_t max_depth();
+        //只对本解析器生效的深度上限，在init之后、解析之前调用，下一次init恢复为max_depth()
+        void set_depth_limit(size_t depth);
+        size_t depth_limit() const
+        {
+            return m_max_depth;
+        }
 
+        //不递归：容器的嵌套通过显式的栈展开，深度受depth_limit()限制
         JsonObject parse();
+        //parse()之后剩余的输入是否只有空白，用于拒绝一个值之后的多余内容
+        bool done();
         JsonObject parse_null();
         bool parse_bool();
         JsonObject parse_number();
         JsonObject parse_string();
+        //返回引号之间的原始内容
+        std::string_view scan_string();
+        //返回解码后的字符串，含转义时结果在内部缓冲区中，下一次读取前有效
+        std::string_view read_string();
+        //当前位置必须是对应的容器，等价于parse()
         JsonObject parse_list();
         JsonObject parse_dict();
 
         char get_next_token();
+        //索引跳转到m_idx处或其后第一个索引项
+        void sync_index();
         void trim_right();
         void skip_comment();
-        static JsonObject from_string(std::string_view content);
+        static JsonObject from_string(std::string_view content, KeyPool *keys = nullptr);
+        //零拷贝解析，结果中的字符串引用buffer，调用者需保证其生命周期或调用materialize()
+        static JsonObject from_buffer(std::string_view buffer);
+        //映射文件后零拷贝解析，文档持有映射，树分配在文档的arena中
+        static Document from_file(const std::string &path);
+        //解析到文档的arena中，zero_copy为true时字符串引用content，intern_keys为true时键驻留在文档的KeyPool中
+        static Document parse_document(std::string_view content, bool zero_copy = false, bool intern_keys = false);
+        //以下并行接口在pool的工作线程上调用时（包括在默认线程池的任务里调用不带pool的版本）退回顺序执行，
+        //不会提交任务后等待而占满工作线程
+
+        //在线程池中并行解析多个文档，结果与输入顺序一致；任一文档出错时抛出第一个错误
+        static std::vector<JsonObject> parse_many(const std::vector<std::string_view> &docs);
+        static std::vector<JsonObject> parse_many(const std::vector<std::string_view> &docs, threadpool::ThreadPool &pool);
+        //顶层是较大的数组时按元素区间切分，在线程池中并行解析后按顺序拼接；其余情况等同于from_string
+        static JsonObject parse_parallel(std::string_view content);
+        static JsonObject parse_parallel(std::string_view content, threadpool::ThreadPool &pool);
+        //顶层是数组时按元素区间并行序列化后拼接，输出与to_string完全一致
+        static std::string to_string_parallel(JsonObject &obj, const WriteOptions &options = WriteOptions());
+        static std::string to_string_parallel(JsonObject &obj, threadpool::ThreadPool &pool,
+                                              const WriteOptions &options = WriteOptions());
         bool is_esc_consume(size_t pos);
 
+        //以下供直接解码到C++类型时使用，均不构造JsonObject
+        Number scan_number();
+        //跳过下一个完整的值，嵌套的容器按结构索引直接跳到匹配的括号之后
+        void skip_value();
+        //下一个记号必须是ch，否则抛出异常
+        void expect(char ch);
+        //下一个值为null时跳过它并返回true
+        bool skip_null();
+
+        //逐个读取对象的键，on_key(key)负责消费对应的值
+        template <class F>
+        void read_object(F &&on_key)
+        {
+            expect('{');
+            char ch = get_next_token();
+            if (ch == '}')
+            {
+                m_idx++;
+                return;
+            }
+            while (true)
+            {
+                if (ch != '"')
+                {
+                    throw std::logic_error("expected key in parse dict");
+                }
+                //on_key需在读取值之前用完key，值中的字符串会复用同一个缓冲区
+                std::string_view key = read_string();
+                expect(':');
+                on_key(key);
+                ch = get_next_token();
+                if (ch == '}')
+                {
+                    m_idx++;
+                    return;
+                }
+                if (ch != ',')
+                {
+                    throw std::logic_error("expected ',' in parse dict");
+                }
+                m_idx++;
+                ch = get_next_token();
+            }
+        }
+
+        //逐个读取数组元素，on_item()负责消费一个值
+        template <class F>
+        void read_array(F &&on_item)
+        {
+            expect('[');
+            if (get_next_token() == ']')
+            {
+                m_idx++;
+                return;
+            }
+            while (true)
+            {
+                on_item();
+                char ch = get_next_token();
+                if (ch == ']')
+                {
+                    m_idx++;
+                    return;
+                }
+                if (ch != ',')
+                {
+                    throw std::logic_error("expected ',' in parse list");
+                }
+                m_idx++;
+            }
+        }
+
         template <class T>
         static std::string ToJSON(const T &src)
         {
-            if constexpr (IS_TYPE(T, int_t))
+            if constexpr (std::is_integral<T>::value)
             {
                 JsonObject object(src);
                 return object.to_string();
             }
-            else if constexpr (IS_TYPE(T, bool_t))
+            else if constexpr (std::is_floating_point<T>::value)
             {
                 JsonObject object(src);
                 return object.to_string();
             }
-            else if constexpr (IS_TYPE(T, double_t))
+            else if constexpr (IS_TYPE(T, string_t) || IS_TYPE(T, pmr_string_t))
             {
                 JsonObject object(src);
                 return object.to_string();
             }
-            else if constexpr (IS_TYPE(T, string_t))
+            else if constexpr (has_fields<T>::value)
             {
-                JsonObject object(src);
-                return object.to_string();
+                //按FJSON_FIELDS直接写入缓冲区，不经过JsonObject
+                Writer writer;
+                write_value(writer, src);
+                return writer.take();
+            }
+            else
+            {
+                fjson::JsonObject obj((fjson::dict_t()));
+                src.FUNC_TO_NAME(obj);
+                return obj.to_string();
             }
-
-            fjson::JsonObject obj((fjson::dict_t()));
-            src.FUNC_TO_NAME(obj);
-            return obj.to_string();
         }
 
         template <class T>
         static T FromJSON(std::string_view src)
         {
-            JsonObject object = from_string(src);
+            if constexpr (has_fields<T>::value)
+            {
+                //边扫描边填充成员，不构造中间的JsonObject
+                Parser &parser = instance();
+                parser.init(src);
+                T ret;
+                read_value(parser, ret);
+                if (!parser.done())
+                    throw std::logic_error("unexpected character after json");
+                return ret;
+            }
             //如果是基本类型
-            if constexpr (is_basic_type<T>())
+            else if constexpr (is_basic_type<T>())
             {
+                JsonObject object = from_string(src);
                 return object.template get_value<T>();
             }
+            else
+            {
+                //调用T类型对应的成岩函数
+                JsonObject object = from_string(src);
+                if (object.get_type() != T_DICT)
+                    throw std::logic_error("not dict type fromjson");
+                T ret;
+                ret.FUNC_FROM_NAME(object);
+                return ret;
+            }
+        }
 
-            //调用T类型对应的成岩函数
-            if (object.get_type() != T_DICT)
-                throw std::logic_error("not dict type fromjson");
-            T ret;
-            ret.FUNC_FROM_NAME(object);
-            return ret;
+    private:
+        //一个未闭合的容器，base为它在m_elems或m_members中的起始位置
+        struct Frame
+        {
+            size_t base;
+            size_t key_base;      //m_escaped_keys的起始位置
+            std::string_view key; //对象中正在解析的值对应的键
+            bool dict;
+        };
+
+        JsonObject parse_scalar(char token);
+        //读取成员的键与冒号，键记录在frame中
+        void read_member_key(Frame &frame);
+        //用暂存的元素或成员构造栈顶的容器并出栈
+        JsonObject finish_container();
+
+        //每个线程一个实例，可重入，扫描用的缓冲区在同一线程的多次解析间复用
+        static Parser &instance();
+
+        char at(size_t pos) const
+        {
+            return pos < m_str.size() ? m_str[pos] : '\0';
         }
 
     private:
-        std::string m_str;
-        int m_idx;
+        std::string_view m_str; //只引用输入，不拷贝
+        size_t m_idx = 0;
+        bool m_zero_copy = false;
+        std::pmr::memory_resource *m_resource = nullptr;
+        KeyPool *m_keys = nullptr;
+        std::vector<JsonObject> m_elems; //解析list时暂存元素，跨多次解析复用
+        std::vector<std::pair<std::string_view, JsonObject>> m_members; //解析dict时暂存成员
+        std::string m_unescaped;                                        //含转义的字符串解码到这里
+        std::deque<std::string> m_escaped_keys; //m_members中含转义的键，deque保证已有元素的地址不变
+        std::vector<Frame> m_frames;            //未闭合的容器
+        size_t m_max_depth = k_default_max_depth;
+        static std::atomic<size_t> s_max_depth;
+
+        //结构索引，m_pos为下一个待访问的索引项，m_indexed为false时逐字节解析
+        std::vector<uint32_t> m_index;
+        size_t m_pos = 0;
+        bool m_indexed = false;
     };
+
+    template <class T>
+    void read_value(Parser &parser, T &value);
+
+    namespace detail
+    {
+        template <class T, size_t I>
+        void read_field(Parser &parser, T &obj)
+        {
+            read_value(parser, obj.*(std::get<I>(fields_of<T>).member));
+        }
+
+        template <class T, size_t... I>
+        constexpr auto make_field_readers(std::index_sequence<I...>)
+        {
+            return std::array<void (*)(Parser &, T &), sizeof...(I)>{&read_field<T, I>...};
+        }
+
+        //按字段序号分派的函数表，与key_table_of<T>配合使用
+        template <class T>
+        inline constexpr auto field_readers = make_field_readers<T>(std::make_index_sequence<field_count<T>>());
+
+        template <class T>
+        T read_integer(Parser &parser)
+        {
+            Number num = parser.scan_number();
+            if (num.kind == Number::DOUBLE)
+                throw std::logic_error("type error in get INT value!");
+            if (num.kind == Number::UINT)
+            {
+                if (num.u > static_cast<uint64_t>(std::numeric_limits<T>::max()))
+                    throw std::out_of_range("integer out of range in get value!");
+                return static_cast<T>(num.u);
+            }
+            if constexpr (std::is_signed<T>::value)
+            {
+                if (num.i < static_cast<int64_t>(std::numeric_limits<T>::min()) ||
+                    num.i > static_cast<int64_t>(std::numeric_limits<T>::max()))
+                    throw std::out_of_range("integer out of range in get value!");
+            }
+            else
+            {
+                if (num.i < 0 || static_cast<uint64_t>(num.i) > static_cast<uint64_t>(std::numeric_limits<T>::max()))
+                    throw std::out_of_range("integer out of range in get value!");
+            }
+            return static_cast<T>(num.i);
+        }
+    } // namespace detail
+
+    /**
+     * @brief
+     * 从parser的当前位置读取一个值写入value，与write_value对称。
+     * FJSON_FIELDS声明的结构体通过编译期哈希表分派键，未知的键整体跳过
+     */
+    template <class T>
+    void read_value(Parser &parser, T &value)
+    {
+        if constexpr (IS_TYPE(T, bool))
+        {
+            const char ch = parser.get_next_token();
+            if (ch != 't' && ch != 'f')
+                throw std::logic_error("type error in get BOOL value!");
+            value = parser.parse_bool();
+        }
+        else if constexpr (std::is_integral<T>::value)
+        {
+            parser.get_next_token();
+            value = detail::read_integer<T>(parser);
+        }
+        else if constexpr (std::is_floating_point<T>::value)
+        {
+            parser.get_next_token();
+            Number num = parser.scan_number();
+            value = num.kind == Number::INT    ? static_cast<T>(num.i)
+                    : num.kind == Number::UINT ? static_cast<T>(num.u)
+                                               : static_cast<T>(num.d);
+        }
+        else if constexpr (IS_TYPE(T, string_t) || IS_TYPE(T, pmr_string_t))
+        {
+            if (parser.get_next_token() != '"')
+                throw std::logic_error("type error in get STRING value!");
+            value.assign(parser.read_string());
+        }
+        else if constexpr (detail::is_optional<T>::value)
+        {
+            if (parser.skip_null())
+                value.reset();
+            else
+                read_value(parser, value.emplace());
+        }
+        else if constexpr (detail::is_vector<T>::value)
+        {
+            value.clear();
+            parser.read_array([&]
+                              {
+                                  typename T::value_type item{};
+                                  read_value(parser, item);
+                                  value.push_back(std::move(item)); });
+        }
+        else if constexpr (detail::is_array<T>::value)
+        {
+            size_t i = 0;
+            parser.read_array([&]
+                              {
+                                  if (i >= value.size())
+                                      throw std::out_of_range("too many elements for std::array");
+                                  read_value(parser, value[i++]); });
+        }
+        else if constexpr (detail::is_string_map<T>::value)
+        {
+            value.clear();
+            parser.read_object([&](std::string_view key)
+                               { read_value(parser, value[typename T::key_type(key)]); });
+        }
+        else if constexpr (IS_TYPE(T, JsonObject))
+        {
+            value = parser.parse();
+        }
+        else if constexpr (has_fields<T>::value)
+        {
+            parser.read_object([&](std::string_view key)
+                               {
+                                   const int index = key_table_of<T>.find(key);
+                                   if (index < 0)
+                                       parser.skip_value();
+                                   else
+                                       detail::field_readers<T>[index](parser, value); });
+        }
+        else
+        {
+            //兼容START_FROM_JSON声明的类型
+            JsonObject obj = parser.parse();
+            if (obj.get_type() != T_DICT)
+                throw std::logic_error("not dict type fromjson");
+            value.FUNC_FROM_NAME(obj);
+        }
+    }
 } // namespace fjson
 
 #endif //! MAGNUM_FJSON_PARSER_H__
\ No newline at end of file
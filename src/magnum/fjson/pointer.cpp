@@ -0,0 +1,61 @@
+#include "pointer.h"
+
+#include <charconv>
+#include <stdexcept>
+
+namespace fjson
+{
+    PathCursor::PathCursor(std::string_view path, bool pointer)
+        : m_rest(path), m_pointer(pointer), m_done(path.empty())
+    {
+        if (m_pointer && !m_done)
+        {
+            if (m_rest.front() != '/')
+                throw std::invalid_argument("json pointer must start with '/'");
+            m_rest.remove_prefix(1);
+        }
+    }
+
+    bool PathCursor::next(std::string_view &token)
+    {
+        if (m_done)
+            return false;
+
+        const char sep = m_pointer ? '/' : '.';
+        const size_t pos = m_rest.find(sep);
+        std::string_view raw = m_rest.substr(0, pos);
+        if (pos == std::string_view::npos)
+            m_done = true;
+        else
+            m_rest.remove_prefix(pos + 1);
+
+        if (!m_pointer || raw.find('~') == std::string_view::npos)
+        {
+            token = raw;
+            return true;
+        }
+
+        m_buf.clear();
+        for (size_t i = 0; i < raw.size(); i++)
+        {
+            if (raw[i] != '~')
+            {
+                m_buf.push_back(raw[i]);
+                continue;
+            }
+            if (i + 1 >= raw.size() || (raw[i + 1] != '0' && raw[i + 1] != '1'))
+                throw std::invalid_argument("invalid escape in json pointer");
+            m_buf.push_back(raw[++i] == '0' ? '~' : '/');
+        }
+        token = m_buf;
+        return true;
+    }
+
+    bool parse_array_index(std::string_view token, size_t &index)
+    {
+        if (token.empty() || (token.size() > 1 && token[0] == '0'))
+            return false;
+        auto res = std::from_chars(token.data(), token.data() + token.size(), index);
+        return res.ec == std::errc() && res.ptr == token.data() + token.size();
+    }
+} // namespace fjson
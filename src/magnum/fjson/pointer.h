@@ -0,0 +1,35 @@
+#ifndef MAGNUM_FJSON_POINTER_H__
+#define MAGNUM_FJSON_POINTER_H__
+
+#include <string>
+#include <string_view>
+
+namespace fjson
+{
+    /**
+     * @brief
+     * 逐段拆分查询路径，JsonObject与LazyDocument共用。
+     * JSON Pointer（RFC 6901）形如 /users/17/name，段中的~1表示'/'，~0表示'~'；
+     * 点分路径形如 users.17.name，段中不做转义。
+     */
+    class PathCursor
+    {
+    public:
+        //pointer为true时按JSON Pointer解析，否则按点分路径解析
+        PathCursor(std::string_view path, bool pointer);
+
+        //取下一段放入token，没有更多的段时返回false，路径格式错误时抛出std::invalid_argument
+        bool next(std::string_view &token);
+
+    private:
+        std::string_view m_rest;
+        bool m_pointer;
+        bool m_done;
+        std::string m_buf; //存放去掉转义后的段
+    };
+
+    //把段解析为数组下标，只接受不带前导零的十进制数
+    bool parse_array_index(std::string_view token, size_t &index);
+} // namespace fjson
+
+#endif //! MAGNUM_FJSON_POINTER_H__
@@ -0,0 +1,351 @@
+#ifndef MAGNUM_FJSON_REFLECT_H__
+#define MAGNUM_FJSON_REFLECT_H__
+
+#include "json_object.h"
+#include "writer.h"
+
+#include <array>
+#include <map>
+#include <optional>
+#include <tuple>
+#include <unordered_map>
+
+/**
+ * 在结构体内部声明需要序列化的成员，序列化时直接写入Writer的缓冲区，不构造JsonObject
+ *
+ * struct Person
+ * {
+ *     std::string name;
+ *     int age;
+ *     Address addr;
+ *     FJSON_FIELDS(Person, FJSON_FIELD(name), FJSON_FIELD(age), FJSON_FIELD_AS(addr, "address"))
+ * };
+ */
+#define FJSON_FIELDS(type, ...)              \
+    using fjson_self_t = type;               \
+    static constexpr auto fjson_fields()     \
+    {                                        \
+        return std::make_tuple(__VA_ARGS__); \
+    }
+#define FJSON_FIELD(member) fjson::make_field(#member, &fjson_self_t::member)
+#define FJSON_FIELD_AS(member, key) fjson::make_field(key, &fjson_self_t::member)
+
+namespace fjson
+{
+    /**
+     * @brief
+     * 一个成员的描述：成员指针、原始键名以及编译期转义好的 "key" 形式。
+     * N为字符串字面量的长度（含结尾的'\0'），最坏情况下每个字符转义为\u00XX，转义规则与Writer一致
+     */
+    template <class C, class M, size_t N>
+    struct Field
+    {
+        using class_type = C;
+        using member_type = M;
+
+        M C::*member;
+        char name[N] = {};
+        char quoted[6 * N + 2] = {};
+        size_t name_len = 0;
+        size_t quoted_len = 0;
+
+        constexpr Field(const char (&key)[N], M C::*ptr)
+            : member(ptr)
+        {
+            constexpr char hex[] = "0123456789abcdef";
+            quoted[quoted_len++] = '"';
+            for (size_t i = 0; i + 1 < N; i++)
+            {
+                const char ch = key[i];
+                name[name_len++] = ch;
+                const char shorthand = ch == '"' || ch == '\\' ? ch
+                                       : ch == '\b'             ? 'b'
+                                       : ch == '\f'             ? 'f'
+                                       : ch == '\n'             ? 'n'
+                                       : ch == '\r'             ? 'r'
+                                       : ch == '\t'             ? 't'
+                                                                 : '\0';
+                if (shorthand != '\0')
+                {
+                    quoted[quoted_len++] = '\\';
+                    quoted[quoted_len++] = shorthand;
+                }
+                else if (static_cast<unsigned char>(ch) < 0x20)
+                {
+                    quoted[quoted_len++] = '\\';
+                    quoted[quoted_len++] = 'u';
+                    quoted[quoted_len++] = '0';
+                    quoted[quoted_len++] = '0';
+                    quoted[quoted_len++] = hex[(ch >> 4) & 0xf];
+                    quoted[quoted_len++] = hex[ch & 0xf];
+                }
+                else
+                {
+                    quoted[quoted_len++] = ch;
+                }
+            }
+            quoted[quoted_len++] = '"';
+        }
+
+        constexpr std::string_view key() const
+        {
+            return {name, name_len};
+        }
+
+        constexpr std::string_view quoted_key() const
+        {
+            return {quoted, quoted_len};
+        }
+    };
+
+    template <class C, class M, size_t N>
+    constexpr Field<C, M, N> make_field(const char (&key)[N], M C::*member)
+    {
+        return Field<C, M, N>(key, member);
+    }
+
+    //是否通过FJSON_FIELDS声明了字段
+    template <class T, class = void>
+    struct has_fields : std::false_type
+    {
+    };
+
+    template <class T>
+    struct has_fields<T, std::void_t<decltype(T::fjson_fields())>> : std::true_type
+    {
+    };
+
+    //是否使用START_TO_JSON宏声明了转换函数
+    template <class T, class = void>
+    struct has_to_json : std::false_type
+    {
+    };
+
+    template <class T>
+    struct has_to_json<T, std::void_t<decltype(std::declval<const T &>()._to_json(std::declval<JsonObject &>()))>>
+        : std::true_type
+    {
+    };
+
+    //字段表在编译期求值一次
+    template <class T>
+    inline constexpr auto fields_of = T::fjson_fields();
+
+    //FNV-1a，seed混入初始值，用于在编译期挑选冲突最少的哈希
+    constexpr uint64_t hash_key(std::string_view key, uint64_t seed)
+    {
+        uint64_t hash = 14695981039346656037ull ^ (seed * 0x9e3779b97f4a7c15ull);
+        for (char ch : key)
+        {
+            hash ^= static_cast<unsigned char>(ch);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    constexpr size_t key_table_size(size_t count)
+    {
+        size_t size = 1;
+        while (size < count * 2)
+            size <<= 1;
+        return size;
+    }
+
+    /**
+     * @brief
+     * 编译期生成的键到字段序号的哈希表。构造时尝试若干个seed，取冲突最少的一个，
+     * 字段不多时通常能得到完美哈希；仍有冲突的槽位通过next串成链表。
+     * 查找时计算一次哈希，再与候选键比较一次即可确定字段。
+     */
+    template <size_t N>
+    struct KeyTable
+    {
+        static constexpr size_t size = key_table_size(N);
+
+        uint64_t seed = 0;
+        int slots[size] = {};
+        int next[N + 1] = {};
+        std::string_view keys[N + 1] = {};
+
+        constexpr explicit KeyTable(const std::array<std::string_view, N> &names)
+        {
+            for (size_t i = 0; i < N; i++)
+            {
+                keys[i] = names[i];
+                for (size_t j = 0; j < i; j++)
+                {
+                    if (keys[j] == keys[i])
+                        throw std::logic_error("duplicate key in FJSON_FIELDS");
+                }
+            }
+
+            size_t best_collisions = N + 1;
+            for (uint64_t candidate = 0; candidate < 64 && best_collisions > 0; candidate++)
+            {
+                bool used[size] = {};
+                size_t collisions = 0;
+                for (size_t i = 0; i < N; i++)
+                {
+                    const size_t slot = hash_key(keys[i], candidate) & (size - 1);
+                    collisions += used[slot];
+                    used[slot] = true;
+                }
+                if (collisions < best_collisions)
+                {
+                    best_collisions = collisions;
+                    seed = candidate;
+                }
+            }
+
+            for (size_t i = 0; i < size; i++)
+                slots[i] = -1;
+            for (size_t i = 0; i < N; i++)
+            {
+                const size_t slot = hash_key(keys[i], seed) & (size - 1);
+                next[i] = slots[slot];
+                slots[slot] = static_cast<int>(i);
+            }
+        }
+
+        //返回键对应的字段序号，不存在时返回-1
+        constexpr int find(std::string_view key) const
+        {
+            for (int i = slots[hash_key(key, seed) & (size - 1)]; i >= 0; i = next[i])
+            {
+                if (keys[i] == key)
+                    return i;
+            }
+            return -1;
+        }
+    };
+
+    template <class T>
+    inline constexpr size_t field_count = std::tuple_size<std::decay_t<decltype(fields_of<T>)>>::value;
+
+    template <class T>
+    inline constexpr auto key_table_of = std::apply([](const auto &...field)
+                                                    { return KeyTable<sizeof...(field)>(
+                                                          std::array<std::string_view, sizeof...(field)>{field.key()...}); },
+                                                    fields_of<T>);
+
+    template <class T>
+    void write_value(Writer &writer, const T &value);
+
+    namespace detail
+    {
+        template <class T>
+        struct is_vector : std::false_type
+        {
+        };
+        template <class T, class A>
+        struct is_vector<std::vector<T, A>> : std::true_type
+        {
+        };
+
+        template <class T>
+        struct is_array : std::false_type
+        {
+        };
+        template <class T, size_t N>
+        struct is_array<std::array<T, N>> : std::true_type
+        {
+        };
+
+        template <class T>
+        struct is_optional : std::false_type
+        {
+        };
+        template <class T>
+        struct is_optional<std::optional<T>> : std::true_type
+        {
+        };
+
+        //键为字符串的map
+        template <class T>
+        struct is_string_map : std::false_type
+        {
+        };
+        template <class K, class V, class C, class A>
+        struct is_string_map<std::map<K, V, C, A>> : std::is_convertible<const K &, std::string_view>
+        {
+        };
+        template <class K, class V, class H, class E, class A>
+        struct is_string_map<std::unordered_map<K, V, H, E, A>> : std::is_convertible<const K &, std::string_view>
+        {
+        };
+    } // namespace detail
+
+    template <class T>
+    void write_value(Writer &writer, const T &value)
+    {
+        if constexpr (IS_TYPE(T, bool))
+        {
+            writer.boolean(value);
+        }
+        else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value)
+        {
+            writer.integer(value);
+        }
+        else if constexpr (std::is_integral<T>::value)
+        {
+            writer.unsigned_integer(value);
+        }
+        else if constexpr (std::is_floating_point<T>::value)
+        {
+            writer.number(value);
+        }
+        else if constexpr (std::is_convertible<const T &, std::string_view>::value)
+        {
+            writer.string(std::string_view(value));
+        }
+        else if constexpr (detail::is_optional<T>::value)
+        {
+            if (value)
+                write_value(writer, *value);
+            else
+                writer.null();
+        }
+        else if constexpr (detail::is_vector<T>::value || detail::is_array<T>::value)
+        {
+            writer.start_array();
+            for (auto &item : value)
+                write_value(writer, item);
+            writer.end_array();
+        }
+        else if constexpr (detail::is_string_map<T>::value)
+        {
+            writer.start_object();
+            for (auto &item : value)
+            {
+                writer.key(item.first);
+                write_value(writer, item.second);
+            }
+            writer.end_object();
+        }
+        else if constexpr (IS_TYPE(T, JsonObject))
+        {
+            writer.write(const_cast<JsonObject &>(value));
+        }
+        else if constexpr (has_fields<T>::value)
+        {
+            writer.start_object();
+            std::apply([&](const auto &...field)
+                       { ((writer.raw_key(field.quoted_key()), write_value(writer, value.*(field.member))), ...); },
+                       fields_of<T>);
+            writer.end_object();
+        }
+        else if constexpr (has_to_json<T>::value)
+        {
+            //兼容START_TO_JSON声明的类型，仍然经过一次JsonObject
+            JsonObject obj((dict_t()));
+            value._to_json(obj);
+            writer.write(obj);
+        }
+        else
+        {
+            static_assert(has_fields<T>::value, "type is not serializable, declare FJSON_FIELDS in it");
+        }
+    }
+} // namespace fjson
+
+#endif //! MAGNUM_FJSON_REFLECT_H__
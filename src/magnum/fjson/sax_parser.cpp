@@ -0,0 +1,335 @@
+#include "sax_parser.h"
+#include "number.h"
+#include "escape.h"
+
+#include <cctype>
+#include <stdexcept>
+
+namespace fjson
+{
+    namespace
+    {
+        inline bool is_number_char(char ch)
+        {
+            return std::isdigit(static_cast<unsigned char>(ch)) || ch == '-' || ch == '+' ||
+                   ch == '.' || ch == 'e' || ch == 'E';
+        }
+
+        inline bool is_literal_char(char ch)
+        {
+            return ch >= 'a' && ch <= 'z';
+        }
+    } // namespace
+
+    SaxParser::SaxParser(SaxHandler &handler, size_t max_depth, size_t max_token)
+        : m_handler(handler), m_max_depth(max_depth), m_max_token(max_token)
+    {
+    }
+
+    void SaxParser::reset()
+    {
+        m_lex = L_NONE;
+        m_expect = E_VALUE;
+        m_stack.clear();
+        m_is_key = false;
+        m_escape = false;
+        m_partial = false;
+        m_token.clear();
+    }
+
+    void SaxParser::feed(std::string_view chunk)
+    {
+        size_t i = 0;
+        m_token_start = 0;
+        while (i < chunk.size())
+        {
+            switch (m_lex)
+            {
+            case L_STRING:
+                i = scan_string(chunk, i);
+                break;
+            case L_NUMBER:
+            case L_LITERAL:
+                i = scan_atom(chunk, i);
+                break;
+            case L_COMMENT_START:
+                if (chunk[i] != '/')
+                    throw std::logic_error("invalid comment area!");
+                m_lex = L_COMMENT;
+                i++;
+                break;
+            case L_COMMENT:
+            {
+                auto pos = chunk.find('\n', i);
+                if (pos == std::string_view::npos)
+                    return;
+                m_lex = L_NONE;
+                i = pos + 1;
+                break;
+            }
+            case L_NONE:
+                if (std::isspace(static_cast<unsigned char>(chunk[i])))
+                {
+                    i++;
+                    break;
+                }
+                if (chunk[i] == '/')
+                {
+                    m_lex = L_COMMENT_START;
+                    i++;
+                    break;
+                }
+                i = on_token(chunk, i);
+                break;
+            }
+        }
+
+        //块结束时还在token中间，暂存已读到的部分
+        if (m_lex == L_STRING || m_lex == L_NUMBER || m_lex == L_LITERAL)
+        {
+            if (m_token.size() + (chunk.size() - m_token_start) > m_max_token)
+                throw std::logic_error("token too long in sax parse");
+            m_token.append(chunk.substr(m_token_start));
+            m_partial = true;
+        }
+    }
+
+    void SaxParser::finish()
+    {
+        if (m_lex == L_NUMBER || m_lex == L_LITERAL) //数字与字面量只能由分隔符或输入结束来终止
+        {
+            m_lex = L_NONE;
+            m_token_start = 0; //内容都已暂存在m_token中
+            complete_atom(take_token({}, 0));
+            m_token.clear();
+        }
+        if (m_lex == L_COMMENT_START)
+            throw std::logic_error("invalid comment area!");
+        //m_lex为L_COMMENT时是一直延续到结尾的行注释，有意接受，见头文件中的说明
+        if (m_lex == L_STRING)
+            throw std::logic_error(R"(expected right '"' in parse string)");
+        if (m_expect != E_DONE)
+            throw std::logic_error("unexpected end of json");
+    }
+
+    size_t SaxParser::on_token(std::string_view chunk, size_t i)
+    {
+        const char ch = chunk[i];
+        switch (m_expect)
+        {
+        case E_DONE:
+            throw std::logic_error("unexpected character after json");
+        case E_COLON:
+            if (ch != ':')
+                throw std::logic_error("expected ':' in parse dict");
+            m_expect = E_VALUE;
+            return i + 1;
+        case E_COMMA_OR_END:
+            if (ch == ',')
+            {
+                m_expect = m_stack.back() == '[' ? E_VALUE : E_KEY;
+                return i + 1;
+            }
+            if ((ch == ']' && m_stack.back() == '[') || (ch == '}' && m_stack.back() == '{'))
+            {
+                m_stack.pop_back();
+                if (ch == ']')
+                    m_handler.end_array();
+                else
+                    m_handler.end_object();
+                value_done();
+                return i + 1;
+            }
+            throw std::logic_error(m_stack.back() == '[' ? "expected ',' in parse list"
+                                                         : "expected ',' in parse dict");
+        case E_KEY_FIRST:
+            if (ch == '}')
+            {
+                m_stack.pop_back();
+                m_handler.end_object();
+                value_done();
+                return i + 1;
+            }
+            [[fallthrough]];
+        case E_KEY:
+            if (ch != '"')
+                throw std::logic_error("expected key in parse dict");
+            m_is_key = true;
+            m_lex = L_STRING;
+            m_token_start = i + 1;
+            return i + 1;
+        case E_ARRAY_FIRST:
+            if (ch == ']')
+            {
+                m_stack.pop_back();
+                m_handler.end_array();
+                value_done();
+                return i + 1;
+            }
+            [[fallthrough]];
+        case E_VALUE:
+            break;
+        }
+
+        //此时期望一个值
+        if (ch == '{' || ch == '[')
+        {
+            if (m_stack.size() >= m_max_depth)
+                throw std::logic_error("json nested too deep");
+            m_stack.push_back(ch);
+            if (ch == '{')
+            {
+                m_handler.start_object();
+                m_expect = E_KEY_FIRST;
+            }
+            else
+            {
+                m_handler.start_array();
+                m_expect = E_ARRAY_FIRST;
+            }
+            return i + 1;
+        }
+        if (ch == '"')
+        {
+            m_is_key = false;
+            m_lex = L_STRING;
+            m_token_start = i + 1;
+            return i + 1;
+        }
+        if (ch == '-' || std::isdigit(static_cast<unsigned char>(ch)))
+        {
+            m_lex = L_NUMBER;
+            m_token_start = i;
+            return scan_atom(chunk, i);
+        }
+        if (ch == 't' || ch == 'f' || ch == 'n')
+        {
+            m_lex = L_LITERAL;
+            m_token_start = i;
+            return scan_atom(chunk, i);
+        }
+        throw std::logic_error("unexpected character in parse json");
+    }
+
+    size_t SaxParser::scan_string(std::string_view chunk, size_t i)
+    {
+        while (i < chunk.size())
+        {
+            if (!m_escape)
+            {
+                //普通字符整段跳过，只在引号、反斜杠和控制字符处停下
+                i = find_unsafe(chunk, i);
+                if (i == std::string_view::npos)
+                    return chunk.size();
+            }
+            const char ch = chunk[i];
+            if (m_escape)
+            {
+                m_escape = false;
+            }
+            else if (ch == '\\')
+            {
+                m_escape = true;
+            }
+            else if (static_cast<unsigned char>(ch) < 0x20)
+            {
+                throw std::logic_error("invalid character in string");
+            }
+            else if (ch == '"')
+            {
+                m_lex = L_NONE;
+                std::string_view token = take_token(chunk, i);
+                if (!is_valid_utf8(token))
+                    throw std::logic_error("invalid utf-8 in json");
+                if (find_escape(token) != std::string_view::npos)
+                {
+                    m_unescaped.clear();
+                    unescape(token, m_unescaped);
+                    token = m_unescaped;
+                }
+                if (m_is_key)
+                {
+                    m_handler.key(token);
+                    m_expect = E_COLON;
+                }
+                else
+                {
+                    m_handler.string(token);
+                    value_done();
+                }
+                m_token.clear();
+                return i + 1;
+            }
+            i++;
+        }
+        return i;
+    }
+
+    size_t SaxParser::scan_atom(std::string_view chunk, size_t i)
+    {
+        const bool number = m_lex == L_NUMBER;
+        while (i < chunk.size() && (number ? is_number_char(chunk[i]) : is_literal_char(chunk[i])))
+            i++;
+        if (i < chunk.size()) //遇到了分隔符，token结束
+        {
+            m_lex = L_NONE;
+            complete_atom(take_token(chunk, i));
+            m_token.clear();
+        }
+        return i;
+    }
+
+    std::string_view SaxParser::take_token(std::string_view chunk, size_t end)
+    {
+        std::string_view tail = chunk.substr(m_token_start, end - m_token_start);
+        if (!m_partial)
+            return tail; //整个token都在当前块中，不需要拷贝
+        m_partial = false;
+        if (m_token.size() + tail.size() > m_max_token)
+            throw std::logic_error("token too long in sax parse");
+        m_token.append(tail);
+        return m_token;
+    }
+
+    void SaxParser::complete_atom(std::string_view token)
+    {
+        if (token.empty())
+            throw std::logic_error("unexpected character in parse json");
+        if (token[0] == 't' || token[0] == 'f' || token[0] == 'n')
+        {
+            if (token == "true")
+                m_handler.boolean(true);
+            else if (token == "false")
+                m_handler.boolean(false);
+            else if (token == "null")
+                m_handler.null();
+            else
+                throw std::logic_error(token[0] == 'n' ? "parse null error" : "parse bool error");
+            value_done();
+            return;
+        }
+
+        const char *last = token.data() + token.size();
+        Number num;
+        if (read_number(token.data(), last, num) != last)
+            throw std::logic_error("invalid character in number");
+        switch (num.kind)
+        {
+        case Number::INT:
+            m_handler.integer(num.i);
+            break;
+        case Number::UINT:
+            m_handler.unsigned_integer(num.u);
+            break;
+        default:
+            m_handler.number(num.d);
+            break;
+        }
+        value_done();
+    }
+
+    void SaxParser::value_done()
+    {
+        m_expect = m_stack.empty() ? E_DONE : E_COMMA_OR_END;
+    }
+} // namespace fjson
\ No newline at end of file
@@ -0,0 +1,113 @@
+#ifndef MAGNUM_FJSON_SAX_PARSER_H__
+#define MAGNUM_FJSON_SAX_PARSER_H__
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fjson
+{
+    /**
+     * @brief
+     * SAX事件回调，默认全部忽略，按需重写。
+     * 传入的string_view只在回调期间有效，需要保留时自行拷贝。
+     */
+    class SaxHandler
+    {
+    public:
+        virtual ~SaxHandler() = default;
+
+        virtual void null() {}
+        virtual void boolean(bool /*value*/) {}
+        virtual void integer(int64_t /*value*/) {}
+        //超出int64范围的无符号整数，默认按double上报
+        virtual void unsigned_integer(uint64_t value)
+        {
+            number(static_cast<double>(value));
+        }
+        virtual void number(double /*value*/) {}
+        virtual void string(std::string_view /*value*/) {}
+        virtual void key(std::string_view /*value*/) {}
+        virtual void start_object() {}
+        virtual void end_object() {}
+        virtual void start_array() {}
+        virtual void end_array() {}
+    };
+
+    /**
+     * @brief
+     * 可恢复的推送式解析器：输入可以按任意长度分块调用feed()，
+     * 跨块的token会被暂存，结束时调用finish()。不构建JsonObject树，
+     * 内存只与嵌套深度和单个token的长度有关，两者都有上限。
+     * 数字按完整的json语法校验，能放进int64的整数通过integer()上报。
+     * 字符串与键校验UTF-8、拒绝未转义的控制字符，解码转义后上报。
+     * 与Parser一样只支持 // 行注释，不支持块注释，单独的'/'与块注释都视为语法错误。
+     * 注释可以出现在任意两个token之间；与Parser不同，最后一行注释可以没有换行，
+     * 直接延续到finish()为止（分块输入时无法预知后面是否还有换行）。
+     * 出错时抛出std::logic_error，之后需要reset()才能继续使用。
+     */
+    class SaxParser
+    {
+    public:
+        explicit SaxParser(SaxHandler &handler, size_t max_depth = 1024, size_t max_token = 64 << 20);
+
+        void feed(std::string_view chunk);
+        void finish();
+        void reset();
+
+        size_t depth() const
+        {
+            return m_stack.size();
+        }
+
+    private:
+        //当前正在扫描的词法单元
+        enum Lex
+        {
+            L_NONE,
+            L_STRING,
+            L_NUMBER,
+            L_LITERAL,
+            L_COMMENT_START, //读到了第一个'/'
+            L_COMMENT        //行注释，直到换行或finish()
+        };
+
+        //语法上期望的下一个token
+        enum Expect
+        {
+            E_VALUE,
+            E_ARRAY_FIRST, //'['之后，可以直接是']'
+            E_KEY_FIRST,   //'{'之后，可以直接是'}'
+            E_KEY,
+            E_COLON,
+            E_COMMA_OR_END,
+            E_DONE
+        };
+
+        size_t on_token(std::string_view chunk, size_t i);
+        size_t scan_string(std::string_view chunk, size_t i);
+        size_t scan_atom(std::string_view chunk, size_t i);
+        std::string_view take_token(std::string_view chunk, size_t end);
+        void complete_atom(std::string_view token);
+        void value_done();
+
+    private:
+        SaxHandler &m_handler;
+        size_t m_max_depth;
+        size_t m_max_token;
+
+        Lex m_lex = L_NONE;
+        Expect m_expect = E_VALUE;
+        std::vector<char> m_stack; //'['或'{'
+
+        bool m_is_key = false;
+        bool m_escape = false;  //字符串中上一个字符是未抵消的'\'
+        bool m_partial = false; //当前token起始于之前的块，内容暂存于m_token
+        size_t m_token_start = 0;
+        std::string m_token;
+        std::string m_unescaped; //含转义的字符串解码后的内容
+    };
+} // namespace fjson
+
+#endif //! MAGNUM_FJSON_SAX_PARSER_H__
\ No newline at end of file
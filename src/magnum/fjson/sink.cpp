@@ -0,0 +1,112 @@
+#include "sink.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define FJSON_HAS_WRITEV 1
+#include <climits>
+#include <sys/uio.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <io.h>
+#endif
+
+namespace fjson
+{
+    namespace
+    {
+        [[noreturn]] void throw_write_error()
+        {
+            throw std::runtime_error(std::string("write to sink error: ") + std::strerror(errno));
+        }
+    } // namespace
+
+    void FdSink::write(std::string_view data)
+    {
+        while (!data.empty())
+        {
+#ifdef FJSON_HAS_WRITEV
+            ssize_t n = ::write(m_fd, data.data(), data.size());
+#else
+            int n = ::_write(m_fd, data.data(), static_cast<unsigned>(std::min<size_t>(data.size(), INT32_MAX)));
+#endif
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                throw_write_error();
+            }
+            data.remove_prefix(static_cast<size_t>(n));
+        }
+    }
+
+    void FdSink::writev(const std::string_view *parts, size_t count)
+    {
+#ifdef FJSON_HAS_WRITEV
+#ifdef IOV_MAX
+        constexpr size_t k_max_iov = IOV_MAX < 64 ? IOV_MAX : 64;
+#else
+        constexpr size_t k_max_iov = 16;
+#endif
+        iovec iov[k_max_iov];
+        while (count > 0)
+        {
+            size_t n = 0;
+            for (; n < count && n < k_max_iov; n++)
+            {
+                iov[n].iov_base = const_cast<char *>(parts[n].data());
+                iov[n].iov_len = parts[n].size();
+            }
+            ssize_t written = ::writev(m_fd, iov, static_cast<int>(n));
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                throw_write_error();
+            }
+            //处理部分写入：跳过已完整写出的片段，剩余部分逐个补写
+            size_t i = 0;
+            size_t left = static_cast<size_t>(written);
+            while (i < n && left >= parts[i].size())
+            {
+                left -= parts[i].size();
+                i++;
+            }
+            if (i < n)
+            {
+                write(parts[i].substr(left));
+                i++;
+            }
+            parts += i;
+            count -= i;
+        }
+#else
+        Sink::writev(parts, count);
+#endif
+    }
+
+    void FileSink::write(std::string_view data)
+    {
+        if (std::fwrite(data.data(), 1, data.size(), m_file) != data.size())
+            throw_write_error();
+    }
+
+    void FileSink::flush()
+    {
+        if (std::fflush(m_file) != 0)
+            throw_write_error();
+    }
+
+    void BufferSink::write(std::string_view data)
+    {
+        if (m_capacity - m_size < data.size())
+            throw std::length_error("buffer sink overflow");
+        std::memcpy(m_data + m_size, data.data(), data.size());
+        m_size += data.size();
+    }
+} // namespace fjson
\ No newline at end of file
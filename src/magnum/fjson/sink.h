@@ -0,0 +1,97 @@
+#ifndef MAGNUM_FJSON_SINK_H__
+#define MAGNUM_FJSON_SINK_H__
+
+#include <cstdio>
+#include <functional>
+#include <string_view>
+
+namespace fjson
+{
+    /**
+     * @brief
+     * 序列化输出的目的地，Writer按块调用，写入失败时抛出std::runtime_error
+     */
+    class Sink
+    {
+    public:
+        virtual ~Sink() = default;
+
+        virtual void write(std::string_view data) = 0;
+
+        //一次写入多个片段，默认逐个写入，支持聚集写的实现可以重写
+        virtual void writev(const std::string_view *parts, size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+                write(parts[i]);
+        }
+
+        virtual void flush() {}
+    };
+
+    //写入文件描述符（文件、socket、管道），writev使用系统调用聚集写
+    class FdSink : public Sink
+    {
+    public:
+        explicit FdSink(int fd) : m_fd(fd) {}
+
+        void write(std::string_view data) override;
+        void writev(const std::string_view *parts, size_t count) override;
+
+    private:
+        int m_fd;
+    };
+
+    class FileSink : public Sink
+    {
+    public:
+        explicit FileSink(FILE *file) : m_file(file) {}
+
+        void write(std::string_view data) override;
+        void flush() override;
+
+    private:
+        FILE *m_file;
+    };
+
+    class CallbackSink : public Sink
+    {
+    public:
+        using callback_t = std::function<void(std::string_view)>;
+
+        explicit CallbackSink(callback_t callback) : m_callback(std::move(callback)) {}
+
+        void write(std::string_view data) override
+        {
+            m_callback(data);
+        }
+
+    private:
+        callback_t m_callback;
+    };
+
+    //写入调用者提供的定长缓冲区，空间不足时抛出std::length_error
+    class BufferSink : public Sink
+    {
+    public:
+        BufferSink(char *data, size_t capacity) : m_data(data), m_capacity(capacity) {}
+
+        void write(std::string_view data) override;
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        std::string_view view() const
+        {
+            return {m_data, m_size};
+        }
+
+    private:
+        char *m_data;
+        size_t m_capacity;
+        size_t m_size = 0;
+    };
+} // namespace fjson
+
+#endif //! MAGNUM_FJSON_SINK_H__
\ No newline at end of file
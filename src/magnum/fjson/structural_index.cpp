@@ -0,0 +1,236 @@
+#include "structural_index.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+namespace fjson
+{
+    namespace
+    {
+        //一个64字节块中各类字符的位图，第i位对应第i个字节
+        struct BlockMasks
+        {
+            uint64_t backslash;
+            uint64_t quote;
+            uint64_t op;    // {}[]:,
+            uint64_t ws;    //与std::isspace一致：空格以及\t\n\v\f\r
+            uint64_t slash; //注释起始
+        };
+
+#if defined(__AVX2__)
+        inline uint64_t movemask64(__m256i lo, __m256i hi)
+        {
+            uint64_t l = static_cast<uint32_t>(_mm256_movemask_epi8(lo));
+            uint64_t h = static_cast<uint32_t>(_mm256_movemask_epi8(hi));
+            return l | (h << 32);
+        }
+
+        void classify(const char *p, BlockMasks &m)
+        {
+            const __m256i in[2] = {_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)),
+                                   _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32))};
+            __m256i r[5][2];
+            for (int i = 0; i < 2; i++)
+            {
+                // '['与'{'、']'与'}'只差0x20，或上0x20后可以合并比较
+                __m256i lower = _mm256_or_si256(in[i], _mm256_set1_epi8(0x20));
+                r[0][i] = _mm256_cmpeq_epi8(in[i], _mm256_set1_epi8('\\'));
+                r[1][i] = _mm256_cmpeq_epi8(in[i], _mm256_set1_epi8('"'));
+                r[2][i] = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(lower, _mm256_set1_epi8('{')),
+                                    _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('}'))),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(in[i], _mm256_set1_epi8(':')),
+                                    _mm256_cmpeq_epi8(in[i], _mm256_set1_epi8(','))));
+                r[3][i] = _mm256_or_si256(
+                    _mm256_cmpeq_epi8(in[i], _mm256_set1_epi8(' ')),
+                    _mm256_and_si256(_mm256_cmpgt_epi8(in[i], _mm256_set1_epi8(8)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8(14), in[i])));
+                r[4][i] = _mm256_cmpeq_epi8(in[i], _mm256_set1_epi8('/'));
+            }
+            m.backslash = movemask64(r[0][0], r[0][1]);
+            m.quote = movemask64(r[1][0], r[1][1]);
+            m.op = movemask64(r[2][0], r[2][1]);
+            m.ws = movemask64(r[3][0], r[3][1]);
+            m.slash = movemask64(r[4][0], r[4][1]);
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        inline uint64_t movemask64(const __m128i (&v)[4])
+        {
+            uint64_t res = 0;
+            for (int i = 0; i < 4; i++)
+                res |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(v[i]))) << (16 * i);
+            return res;
+        }
+
+        void classify(const char *p, BlockMasks &m)
+        {
+            __m128i r[5][4];
+            for (int i = 0; i < 4; i++)
+            {
+                __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * i));
+                __m128i lower = _mm_or_si128(in, _mm_set1_epi8(0x20));
+                r[0][i] = _mm_cmpeq_epi8(in, _mm_set1_epi8('\\'));
+                r[1][i] = _mm_cmpeq_epi8(in, _mm_set1_epi8('"'));
+                r[2][i] = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8('{')),
+                                 _mm_cmpeq_epi8(lower, _mm_set1_epi8('}'))),
+                    _mm_or_si128(_mm_cmpeq_epi8(in, _mm_set1_epi8(':')),
+                                 _mm_cmpeq_epi8(in, _mm_set1_epi8(','))));
+                r[3][i] = _mm_or_si128(
+                    _mm_cmpeq_epi8(in, _mm_set1_epi8(' ')),
+                    _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8(8)),
+                                  _mm_cmplt_epi8(in, _mm_set1_epi8(14))));
+                r[4][i] = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+            }
+            m.backslash = movemask64(r[0]);
+            m.quote = movemask64(r[1]);
+            m.op = movemask64(r[2]);
+            m.ws = movemask64(r[3]);
+            m.slash = movemask64(r[4]);
+        }
+#else
+        void classify(const char *p, BlockMasks &m)
+        {
+            m = BlockMasks{0, 0, 0, 0, 0};
+            for (int i = 0; i < 64; i++)
+            {
+                const uint64_t bit = uint64_t(1) << i;
+                const char ch = p[i];
+                switch (ch)
+                {
+                case '\\':
+                    m.backslash |= bit;
+                    break;
+                case '"':
+                    m.quote |= bit;
+                    break;
+                case '{':
+                case '}':
+                case '[':
+                case ']':
+                case ':':
+                case ',':
+                    m.op |= bit;
+                    break;
+                case ' ':
+                case '\t':
+                case '\n':
+                case '\v':
+                case '\f':
+                case '\r':
+                    m.ws |= bit;
+                    break;
+                case '/':
+                    m.slash |= bit;
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+#endif
+
+        //前缀异或：第i位为第0..i位的异或，用于从引号位置得到字符串区间
+        inline uint64_t prefix_xor(uint64_t bits)
+        {
+#if defined(__PCLMUL__)
+            __m128i all_ones = _mm_set1_epi8(static_cast<char>(0xFF));
+            __m128i res = _mm_clmulepi64_si128(_mm_set_epi64x(0, static_cast<long long>(bits)), all_ones, 0);
+            return static_cast<uint64_t>(_mm_cvtsi128_si64(res));
+#else
+            bits ^= bits << 1;
+            bits ^= bits << 2;
+            bits ^= bits << 4;
+            bits ^= bits << 8;
+            bits ^= bits << 16;
+            bits ^= bits << 32;
+            return bits;
+#endif
+        }
+
+        //找出被转义的字符：奇数个连续反斜杠之后的那个字符，prev_escaped跨块传递
+        inline uint64_t find_escaped(uint64_t backslash, uint64_t &prev_escaped)
+        {
+            backslash &= ~prev_escaped;
+            const uint64_t follows_escape = (backslash << 1) | prev_escaped;
+            const uint64_t even_bits = 0x5555555555555555ULL;
+            const uint64_t odd_sequence_starts = backslash & ~even_bits & ~follows_escape;
+            const uint64_t sequences_starting_on_even_bits = odd_sequence_starts + backslash;
+            prev_escaped = sequences_starting_on_even_bits < odd_sequence_starts ? 1 : 0;
+            const uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+            return (even_bits ^ invert_mask) & follows_escape;
+        }
+
+        inline int trailing_zeros(uint64_t bits)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_ctzll(bits);
+#else
+            int n = 0;
+            while (!(bits & 1))
+            {
+                bits >>= 1;
+                n++;
+            }
+            return n;
+#endif
+        }
+    } // namespace
+
+    bool build_structural_index(std::string_view src, std::vector<uint32_t> &index)
+    {
+        index.clear();
+        if (src.size() >= UINT32_MAX)
+            return false;
+
+        uint64_t prev_escaped = 0;
+        uint64_t prev_in_string = 0; //全0或全1
+        uint64_t prev_scalar = 0;
+        size_t count = 0;
+        BlockMasks m;
+
+        for (size_t base = 0; base < src.size(); base += 64)
+        {
+            const char *p = src.data() + base;
+            char tail[64];
+            if (src.size() - base < 64) //最后不足64字节的部分用空白填充
+            {
+                std::memset(tail, ' ', sizeof(tail));
+                std::memcpy(tail, p, src.size() - base);
+                p = tail;
+            }
+            classify(p, m);
+
+            const uint64_t escaped = find_escaped(m.backslash, prev_escaped);
+            const uint64_t quote = m.quote & ~escaped;
+            //字符串区间：包含开始引号，不包含结束引号
+            const uint64_t in_string = prefix_xor(quote) ^ prev_in_string;
+            prev_in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+
+            if (m.slash & ~in_string)
+                return false;
+
+            const uint64_t op = m.op & ~in_string;
+            const uint64_t scalar = ~(m.op | m.ws | quote | in_string);
+            const uint64_t scalar_start = scalar & ~((scalar << 1) | prev_scalar);
+            prev_scalar = scalar >> 63;
+
+            uint64_t structurals = op | quote | scalar_start;
+            if (index.size() < count + 64)
+                index.resize(std::max(count + 64, index.size() * 2));
+            uint32_t *out = index.data() + count;
+            while (structurals)
+            {
+                *out++ = static_cast<uint32_t>(base + trailing_zeros(structurals));
+                structurals &= structurals - 1;
+            }
+            count = out - index.data();
+        }
+        index.resize(count);
+        return prev_in_string == 0;
+    }
+} // namespace fjson
\ No newline at end of file
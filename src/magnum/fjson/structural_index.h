@@ -0,0 +1,23 @@
+#ifndef MAGNUM_FJSON_STRUCTURAL_INDEX_H__
+#define MAGNUM_FJSON_STRUCTURAL_INDEX_H__
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace fjson
+{
+    /**
+     * @brief
+     * 解析前的向量化扫描（参考simdjson的stage 1），每次处理64字节。
+     * 索引中按顺序记录：字符串外的 {}[]:, 、所有未转义的引号（开始与结束）、
+     * 以及字符串外每段标量（数字、true/false/null）的首字符。
+     * 因此任意空白之后的第一个非空白字符一定在索引中，解析时可以直接跳转。
+     *
+     * 遇到字符串外的 '/'（注释）或未闭合的字符串时返回false，由调用者退回逐字节解析。
+     * 编译期根据 __AVX2__ / __SSE2__ 选择实现，否则使用标量实现。
+     */
+    bool build_structural_index(std::string_view src, std::vector<uint32_t> &index);
+} // namespace fjson
+
+#endif //! MAGNUM_FJSON_STRUCTURAL_INDEX_H__
\ No newline at end of file
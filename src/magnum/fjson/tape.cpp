@@ -0,0 +1,580 @@
+#include "tape.h"
+#include "parser.h"
+#include "pointer.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace fjson
+{
+    namespace
+    {
+        constexpr char k_magic[4] = {'F', 'J', 'T', 'P'};
+        constexpr uint32_t k_header_size = 16;
+        constexpr uint16_t k_flag_big_endian = 1;
+
+        uint16_t host_flags()
+        {
+            const uint16_t probe = 1;
+            unsigned char first;
+            std::memcpy(&first, &probe, 1);
+            return first == 1 ? 0 : k_flag_big_endian;
+        }
+
+        [[noreturn]] void throw_corrupt()
+        {
+            throw std::runtime_error("corrupt json tape");
+        }
+
+        //to_json/write按层递归，与文本解析共用嵌套深度上限，防止构造出的深层磁带耗尽栈
+        void check_depth(size_t depth)
+        {
+            if (depth >= Parser::max_depth())
+                throw std::runtime_error("json tape nesting too deep");
+        }
+
+        class TapeEncoder
+        {
+        public:
+            std::string encode(JsonObject &root)
+            {
+                m_out.assign(k_header_size, '\0');
+                const uint32_t root_offset = write(root);
+                const uint16_t version = Tape::k_version;
+                const uint16_t flags = host_flags();
+                std::memcpy(&m_out[0], k_magic, 4);
+                std::memcpy(&m_out[4], &version, 2);
+                std::memcpy(&m_out[6], &flags, 2);
+                patch_u32(8, root_offset);
+                patch_u32(12, static_cast<uint32_t>(m_out.size()));
+                return std::move(m_out);
+            }
+
+        private:
+            uint32_t offset() const
+            {
+                if (m_out.size() > UINT32_MAX)
+                    throw std::length_error("json tape exceeds 4GB");
+                return static_cast<uint32_t>(m_out.size());
+            }
+
+            void put_u8(uint8_t value)
+            {
+                m_out.push_back(static_cast<char>(value));
+            }
+
+            template <class T>
+            void put(T value)
+            {
+                m_out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+            }
+
+            void put_str(std::string_view str)
+            {
+                if (str.size() > UINT32_MAX)
+                    throw std::length_error("json tape exceeds 4GB");
+                put(static_cast<uint32_t>(str.size()));
+                m_out.append(str.data(), str.size());
+            }
+
+            void patch_u32(size_t pos, uint32_t value)
+            {
+                std::memcpy(&m_out[pos], &value, sizeof(value));
+            }
+
+            uint32_t write_key(std::string_view key)
+            {
+                auto it = m_keys.find(key);
+                if (it != m_keys.end())
+                    return it->second;
+                const uint32_t pos = offset();
+                put_str(key);
+                m_keys.emplace(key, pos);
+                return pos;
+            }
+
+            //不递归：未写完的容器放在m_frames中，按深度优先的顺序写出，布局与逐层递归时相同
+            uint32_t write(JsonObject &root)
+            {
+                const uint32_t root_offset = write_node(root);
+                while (!m_frames.empty())
+                {
+                    Frame &frame = m_frames.back();
+                    if (frame.next == frame.count)
+                    {
+                        if (frame.obj->get_type() == T_DICT)
+                            write_order(frame);
+                        m_frames.pop_back();
+                        continue;
+                    }
+                    const size_t i = frame.next++;
+                    const size_t table = frame.table;
+                    //write_node可能压入新的帧，frame在此之后不再使用
+                    if (frame.obj->get_type() == T_LIST)
+                    {
+                        JsonObject &item = frame.obj->get_value<list_t>()[i];
+                        patch_u32(table + i * 4, write_node(item));
+                    }
+                    else
+                    {
+                        auto &member = frame.obj->get_value<dict_t>().begin()[i];
+                        patch_u32(table + i * 8, write_key(member.first.view()));
+                        patch_u32(table + i * 8 + 4, write_node(member.second));
+                    }
+                }
+                return root_offset;
+            }
+
+            //一个已写出头部、元素尚未写完的容器
+            struct Frame
+            {
+                JsonObject *obj;
+                size_t table; //偏移表的位置
+                size_t next;  //下一个要写的元素
+                size_t count;
+            };
+
+            //写出标量，或写出容器的头部并占位偏移表、压入m_frames，返回节点的偏移
+            uint32_t write_node(JsonObject &obj)
+            {
+                const uint32_t pos = offset();
+                const TYPE type = obj.get_type();
+                put_u8(static_cast<uint8_t>(type));
+                switch (type)
+                {
+                case T_NULL:
+                    break;
+                case T_BOOL:
+                    put_u8(obj.get_value<bool_t>() ? 1 : 0);
+                    break;
+                case T_INT:
+                    put(obj.get_value<int_t>());
+                    break;
+                case T_UINT:
+                    put(obj.get_value<uint_t>());
+                    break;
+                case T_DOUBLE:
+                    put(obj.get_value<double_t>());
+                    break;
+                case T_STRING:
+                    put_str(obj.get_view());
+                    break;
+                case T_LIST:
+                {
+                    const size_t n = obj.get_value<list_t>().size();
+                    put(static_cast<uint32_t>(n));
+                    //先占位偏移表，写完元素后回填
+                    m_frames.push_back({&obj, m_out.size(), 0, n});
+                    m_out.append(n * 4, '\0');
+                    break;
+                }
+                case T_DICT:
+                {
+                    const size_t n = obj.get_value<dict_t>().size();
+                    put(static_cast<uint32_t>(n));
+                    //键值偏移表之后是按键排序的成员序号
+                    m_frames.push_back({&obj, m_out.size(), 0, n});
+                    m_out.append(n * 12, '\0');
+                    break;
+                }
+                }
+                return pos;
+            }
+
+            void write_order(const Frame &frame)
+            {
+                auto &dict = frame.obj->get_value<dict_t>();
+                const size_t n = frame.count;
+                std::vector<uint32_t> order(n);
+                for (size_t i = 0; i < n; i++)
+                    order[i] = static_cast<uint32_t>(i);
+                auto first = dict.begin();
+                std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+                          { return first[a].first.view() < first[b].first.view(); });
+                for (size_t i = 0; i < n; i++)
+                    patch_u32(frame.table + n * 8 + i * 4, order[i]);
+            }
+
+            std::string m_out;
+            std::unordered_map<std::string_view, uint32_t> m_keys; //键的内容在编码期间一直有效
+            std::vector<Frame> m_frames;
+        };
+    } // namespace
+
+    uint8_t TapeValue::tag() const
+    {
+        if (m_data == nullptr || m_offset >= m_size)
+            throw_corrupt();
+        const uint8_t tag = static_cast<uint8_t>(m_data[m_offset]);
+        if (tag > T_UINT)
+            throw_corrupt();
+        return tag;
+    }
+
+    uint32_t TapeValue::read_u32(size_t offset) const
+    {
+        if (offset > m_size || m_size - offset < 4)
+            throw_corrupt();
+        uint32_t value;
+        std::memcpy(&value, m_data + offset, 4);
+        return value;
+    }
+
+    std::string_view TapeValue::read_str(size_t offset) const
+    {
+        const uint32_t len = read_u32(offset);
+        if (m_size - offset - 4 < len)
+            throw_corrupt();
+        return {m_data + offset + 4, len};
+    }
+
+    TapeValue TapeValue::child(size_t pos) const
+    {
+        const uint32_t offset = read_u32(pos);
+        if (offset <= m_offset)
+            throw_corrupt();
+        return TapeValue(m_data, m_size, offset);
+    }
+
+    uint32_t TapeValue::count(uint8_t expected) const
+    {
+        if (tag() != expected)
+            return 0;
+        return read_u32(static_cast<size_t>(m_offset) + 1);
+    }
+
+    TYPE TapeValue::get_type() const
+    {
+        return static_cast<TYPE>(tag());
+    }
+
+    bool TapeValue::get_bool() const
+    {
+        if (tag() != T_BOOL || static_cast<size_t>(m_offset) + 2 > m_size)
+            THROW_GET_ERROR(BOOL);
+        return m_data[m_offset + 1] != 0;
+    }
+
+    int64_t TapeValue::get_int() const
+    {
+        if (tag() != T_INT || static_cast<size_t>(m_offset) + 9 > m_size)
+            THROW_GET_ERROR(INT);
+        int64_t value;
+        std::memcpy(&value, m_data + m_offset + 1, 8);
+        return value;
+    }
+
+    uint64_t TapeValue::get_uint() const
+    {
+        if (tag() != T_UINT || static_cast<size_t>(m_offset) + 9 > m_size)
+            THROW_GET_ERROR(UINT);
+        uint64_t value;
+        std::memcpy(&value, m_data + m_offset + 1, 8);
+        return value;
+    }
+
+    double TapeValue::get_double() const
+    {
+        switch (tag())
+        {
+        case T_INT:
+            return static_cast<double>(get_int());
+        case T_UINT:
+            return static_cast<double>(get_uint());
+        case T_DOUBLE:
+        {
+            if (static_cast<size_t>(m_offset) + 9 > m_size)
+                throw_corrupt();
+            double value;
+            std::memcpy(&value, m_data + m_offset + 1, 8);
+            return value;
+        }
+        default:
+            THROW_GET_ERROR(DOUBLE);
+        }
+    }
+
+    std::string_view TapeValue::get_view() const
+    {
+        if (tag() != T_STRING)
+            THROW_GET_ERROR(string);
+        return read_str(static_cast<size_t>(m_offset) + 1);
+    }
+
+    size_t TapeValue::size() const
+    {
+        const uint8_t t = tag();
+        return t == T_LIST || t == T_DICT ? read_u32(static_cast<size_t>(m_offset) + 1) : 0;
+    }
+
+    TapeValue TapeValue::operator[](size_t index) const
+    {
+        if (!m_data || index >= count(T_LIST))
+            return {};
+        return child(static_cast<size_t>(m_offset) + 5 + index * 4);
+    }
+
+    TapeValue TapeValue::operator[](std::string_view key) const
+    {
+        const size_t n = m_data ? count(T_DICT) : 0;
+        const size_t entries = static_cast<size_t>(m_offset) + 5;
+        const size_t sorted = entries + n * 8;
+        //按排序表二分查找
+        size_t lo = 0, hi = n;
+        while (lo < hi)
+        {
+            const size_t mid = lo + (hi - lo) / 2;
+            const size_t i = read_u32(sorted + mid * 4);
+            if (i >= n)
+                throw_corrupt();
+            const std::string_view name = read_str(read_u32(entries + i * 8));
+            if (name == key)
+                return child(entries + i * 8 + 4);
+            if (name < key)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return {};
+    }
+
+    std::string_view TapeValue::key_at(size_t i) const
+    {
+        if (i >= count(T_DICT))
+            throw std::out_of_range("member index out of range");
+        return read_str(read_u32(static_cast<size_t>(m_offset) + 5 + i * 8));
+    }
+
+    TapeValue TapeValue::value_at(size_t i) const
+    {
+        if (i >= count(T_DICT))
+            throw std::out_of_range("member index out of range");
+        return child(static_cast<size_t>(m_offset) + 5 + i * 8 + 4);
+    }
+
+    TapeValue TapeValue::find_pointer(std::string_view pointer) const
+    {
+        return find(pointer, true);
+    }
+
+    TapeValue TapeValue::find_path(std::string_view path) const
+    {
+        return find(path, false);
+    }
+
+    TapeValue TapeValue::find(std::string_view path, bool pointer) const
+    {
+        PathCursor cursor(path, pointer);
+        TapeValue cur = *this;
+        std::string_view token;
+        while (cur && cursor.next(token))
+        {
+            const uint8_t t = cur.tag();
+            size_t i;
+            if (t == T_DICT)
+                cur = cur[token];
+            else if (t == T_LIST && parse_array_index(token, i))
+                cur = cur[i];
+            else
+                return {};
+        }
+        return cur;
+    }
+
+    JsonObject TapeValue::to_json(std::pmr::memory_resource *resource) const
+    {
+        return to_json(resource, 0);
+    }
+
+    JsonObject TapeValue::to_json(std::pmr::memory_resource *resource, size_t depth) const
+    {
+        switch (tag())
+        {
+        case T_NULL:
+            return {};
+        case T_BOOL:
+            return get_bool();
+        case T_INT:
+            return get_int();
+        case T_UINT:
+            return get_uint();
+        case T_DOUBLE:
+            return get_double();
+        case T_STRING:
+        {
+            JsonObject str;
+            str.Str(get_view(), resource);
+            return str;
+        }
+        case T_LIST:
+        {
+            check_depth(depth);
+            const size_t n = size();
+            list_t list(resource);
+            list.reserve(n);
+            for (size_t i = 0; i < n; i++)
+                list.push_back((*this)[i].to_json(resource, depth + 1));
+            return list;
+        }
+        default:
+        {
+            check_depth(depth);
+            const size_t n = size();
+            dict_t dict(resource);
+            dict.reserve(n);
+            for (size_t i = 0; i < n; i++)
+                dict.insert_or_assign(key_at(i), value_at(i).to_json(resource, depth + 1));
+            return dict;
+        }
+        }
+    }
+
+    void TapeValue::write(Writer &writer) const
+    {
+        write(writer, 0);
+    }
+
+    void TapeValue::write(Writer &writer, size_t depth) const
+    {
+        switch (tag())
+        {
+        case T_NULL:
+            writer.null();
+            break;
+        case T_BOOL:
+            writer.boolean(get_bool());
+            break;
+        case T_INT:
+            writer.integer(get_int());
+            break;
+        case T_UINT:
+            writer.unsigned_integer(get_uint());
+            break;
+        case T_DOUBLE:
+            writer.number(get_double());
+            break;
+        case T_STRING:
+            writer.string(get_view());
+            break;
+        case T_LIST:
+        {
+            check_depth(depth);
+            const size_t n = size();
+            writer.start_array();
+            for (size_t i = 0; i < n; i++)
+                (*this)[i].write(writer, depth + 1);
+            writer.end_array();
+            break;
+        }
+        default:
+        {
+            check_depth(depth);
+            const size_t n = size();
+            writer.start_object();
+            for (size_t i = 0; i < n; i++)
+            {
+                writer.key(key_at(i));
+                value_at(i).write(writer, depth + 1);
+            }
+            writer.end_object();
+            break;
+        }
+        }
+    }
+
+    Tape::Tape(std::string_view bytes)
+        : m_bytes(bytes)
+    {
+        check_header();
+    }
+
+    Tape::Tape(Tape &&other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    Tape &Tape::operator=(Tape &&other) noexcept
+    {
+        if (this != &other)
+        {
+            const bool owned = !other.m_owned.empty() && other.m_bytes.data() == other.m_owned.data();
+            m_owned = std::move(other.m_owned);
+            m_file = std::move(other.m_file);
+            m_bytes = owned ? std::string_view(m_owned) : other.m_bytes;
+            other.m_bytes = {};
+        }
+        return *this;
+    }
+
+    Tape Tape::from_json(JsonObject &obj)
+    {
+        Tape tape;
+        tape.m_owned = TapeEncoder().encode(obj);
+        tape.m_bytes = tape.m_owned;
+        return tape;
+    }
+
+    Tape Tape::from_text(std::string_view json)
+    {
+        //键与字符串只在编码期间使用，零拷贝解析即可
+        JsonObject obj = Parser::from_buffer(json);
+        return from_json(obj);
+    }
+
+    Tape Tape::load(const std::string &path)
+    {
+        Tape tape;
+        tape.m_file = MappedFile(path);
+        tape.m_bytes = tape.m_file.view();
+        tape.check_header();
+        return tape;
+    }
+
+    void Tape::save(const std::string &path) const
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw std::runtime_error("open file error: " + path);
+        out.write(m_bytes.data(), static_cast<std::streamsize>(m_bytes.size()));
+        if (!out)
+            throw std::runtime_error("write file error: " + path);
+    }
+
+    void Tape::check_header() const
+    {
+        if (m_bytes.size() < k_header_size || std::memcmp(m_bytes.data(), k_magic, 4) != 0)
+            throw std::runtime_error("not a json tape");
+        uint16_t version, flags;
+        uint32_t total;
+        std::memcpy(&version, m_bytes.data() + 4, 2);
+        std::memcpy(&flags, m_bytes.data() + 6, 2);
+        std::memcpy(&total, m_bytes.data() + 12, 4);
+        if (version == 0 || version > k_version)
+            throw std::runtime_error("unsupported json tape version " + std::to_string(version));
+        if (flags != host_flags())
+            throw std::runtime_error("json tape byte order mismatch");
+        if (total != m_bytes.size())
+            throw_corrupt();
+    }
+
+    TapeValue Tape::root() const
+    {
+        //默认构造或被移走的Tape没有内容，加载过的磁带在构造时已经检查过头部
+        if (m_bytes.size() < k_header_size)
+            throw std::logic_error("no json tape loaded");
+        uint32_t offset;
+        std::memcpy(&offset, m_bytes.data() + 8, 4);
+        return TapeValue(m_bytes.data(), m_bytes.size(), offset);
+    }
+
+    std::string Tape::to_text(const WriteOptions &options) const
+    {
+        Writer writer(options);
+        writer.reserve(m_bytes.size());
+        root().write(writer);
+        return writer.take();
+    }
+} // namespace fjson
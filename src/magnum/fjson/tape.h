@@ -0,0 +1,131 @@
+#ifndef MAGNUM_FJSON_TAPE_H__
+#define MAGNUM_FJSON_TAPE_H__
+
+#include "json_object.h"
+#include "document.h"
+#include "writer.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace fjson
+{
+    /**
+     * 二进制磁带格式（版本1），所有整数为本机字节序，偏移量是相对文件开头的uint32：
+     *
+     *   文件头   "FJTP" | u16 版本 | u16 标志(bit0: 大端) | u32 根节点偏移 | u32 文件总长
+     *   null     u8 类型
+     *   bool     u8 类型 | u8 值
+     *   数字     u8 类型 | 8字节 int64 / uint64 / double
+     *   字符串   u8 类型 | u32 长度 | 字节
+     *   数组     u8 类型 | u32 个数 | u32 元素偏移[个数]
+     *   对象     u8 类型 | u32 个数 | {u32 键偏移, u32 值偏移}[个数] | u32 按键排序的成员序号[个数]
+     *
+     * 键以 u32 长度 | 字节 的形式存放，相同的键只写一次。成员按插入顺序存放，排序表用于二分查找。
+     * 读取时不做任何解析，所有访问都检查越界，损坏的文件抛出std::runtime_error。
+     */
+    class TapeValue
+    {
+    public:
+        TapeValue() = default;
+
+        explicit operator bool() const
+        {
+            return m_data != nullptr;
+        }
+
+        TYPE get_type() const;
+
+        bool get_bool() const;
+        int64_t get_int() const;
+        uint64_t get_uint() const;
+        //整数也可以按浮点数读取
+        double get_double() const;
+        std::string_view get_view() const;
+
+        //对象的成员数或数组的元素数
+        size_t size() const;
+        //数组的元素，越界或不是数组时返回空值
+        TapeValue operator[](size_t index) const;
+        //对象的成员，不存在或不是对象时返回空值
+        TapeValue operator[](std::string_view key) const;
+        //按插入顺序访问对象的第i个成员
+        std::string_view key_at(size_t i) const;
+        TapeValue value_at(size_t i) const;
+
+        TapeValue find_pointer(std::string_view pointer) const;
+        TapeValue find_path(std::string_view path) const;
+
+        JsonObject to_json(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const;
+        //不经过JsonObject直接写出文本
+        void write(Writer &writer) const;
+
+    private:
+        friend class Tape;
+
+        TapeValue(const char *data, size_t size, uint32_t offset) : m_data(data), m_size(size), m_offset(offset) {}
+
+        //pos处存放的子节点偏移。子节点总是写在父节点之后，不在其后的偏移视为损坏，
+        //因此沿子节点走下去偏移严格递增，损坏的文件也不会形成环
+        TapeValue child(size_t pos) const;
+        uint8_t tag() const;
+        uint32_t read_u32(size_t offset) const;
+        //offset处的 u32 长度 | 字节
+        std::string_view read_str(size_t offset) const;
+        //容器的个数，要求类型为tag
+        uint32_t count(uint8_t expected) const;
+        TapeValue find(std::string_view path, bool pointer) const;
+        //depth为当前嵌套层数，超过Parser::max_depth()时抛出异常
+        JsonObject to_json(std::pmr::memory_resource *resource, size_t depth) const;
+        void write(Writer &writer, size_t depth) const;
+
+    private:
+        const char *m_data = nullptr; //整个磁带
+        size_t m_size = 0;
+        uint32_t m_offset = 0; //节点在磁带中的偏移
+    };
+
+    class Tape
+    {
+    public:
+        static constexpr uint16_t k_version = 1;
+
+        Tape() = default;
+        //借用bytes，调用者保证其生命周期
+        explicit Tape(std::string_view bytes);
+
+        Tape(const Tape &other) = delete;
+        Tape &operator=(const Tape &other) = delete;
+        Tape(Tape &&other) noexcept;
+        Tape &operator=(Tape &&other) noexcept;
+
+        static Tape from_json(JsonObject &obj);
+        static Tape from_text(std::string_view json);
+        //映射磁带文件，直接在映射的内存上访问
+        static Tape load(const std::string &path);
+
+        void save(const std::string &path) const;
+
+        //默认构造或被移走、没有磁带内容时抛出std::logic_error
+        TapeValue root() const;
+
+        std::string to_text(const WriteOptions &options = WriteOptions()) const;
+
+        std::string_view data() const
+        {
+            return m_bytes;
+        }
+
+    private:
+        void check_header() const;
+
+    private:
+        std::string m_owned;
+        MappedFile m_file;
+        std::string_view m_bytes;
+    };
+} // namespace fjson
+
+#endif //! MAGNUM_FJSON_TAPE_H__
@@ -0,0 +1,299 @@
+#include "writer.h"
+#include "escape.h"
+
+#include <charconv>
+#include <cmath>
+
+namespace fjson
+{
+    Writer::Writer(WriteOptions options)
+        : m_options(options)
+    {
+    }
+
+    Writer::Writer(Sink &sink, WriteOptions options, size_t flush_threshold)
+        : m_options(options), m_sink(&sink), m_flush_threshold(flush_threshold)
+    {
+        m_buf.reserve(flush_threshold + 256);
+    }
+
+    void Writer::flush()
+    {
+        if (m_sink == nullptr)
+            return;
+        flush_buffer();
+        m_sink->flush();
+    }
+
+    void Writer::flush_buffer()
+    {
+        if (!m_buf.empty())
+        {
+            m_sink->write(m_buf);
+            m_buf.clear();
+        }
+    }
+
+    void Writer::write(JsonObject &obj)
+    {
+        switch (obj.get_type())
+        {
+        case T_NULL:
+            null();
+            break;
+        case T_BOOL:
+            boolean(obj.get_value<bool_t>());
+            break;
+        case T_INT:
+            integer(obj.get_value<int_t>());
+            break;
+        case T_UINT:
+            unsigned_integer(obj.get_value<uint_t>());
+            break;
+        case T_DOUBLE:
+            number(obj.get_value<double_t>());
+            break;
+        case T_STRING:
+            string(obj.get_view());
+            break;
+        case T_LIST:
+            start_array();
+            for (auto &item : obj.get_value<list_t>())
+            {
+                write(item);
+            }
+            end_array();
+            break;
+        case T_DICT:
+            start_object();
+            for (auto &item : obj.get_value<dict_t>())
+            {
+                key(item.first);
+                write(item.second);
+            }
+            end_object();
+            break;
+        }
+    }
+
+    void Writer::null()
+    {
+        before_value();
+        put("null");
+    }
+
+    void Writer::boolean(bool value)
+    {
+        before_value();
+        put(value ? std::string_view("true") : std::string_view("false"));
+    }
+
+    void Writer::integer(int64_t value)
+    {
+        before_value();
+        char buf[24];
+        auto res = std::to_chars(buf, buf + sizeof(buf), value);
+        put(std::string_view(buf, res.ptr - buf));
+    }
+
+    void Writer::unsigned_integer(uint64_t value)
+    {
+        before_value();
+        char buf[24];
+        auto res = std::to_chars(buf, buf + sizeof(buf), value);
+        put(std::string_view(buf, res.ptr - buf));
+    }
+
+    void Writer::number(double value)
+    {
+        before_value();
+        if (!std::isfinite(value)) // json不能表示nan与inf
+        {
+            put("null");
+            return;
+        }
+        char buf[32];
+        auto res = std::to_chars(buf, buf + sizeof(buf), value);
+        std::string_view str(buf, res.ptr - buf);
+        put(str);
+        //保证重新解析后仍然是浮点数
+        if (str.find_first_of(".e") == std::string_view::npos)
+            put(".0");
+    }
+
+    void Writer::string(std::string_view value)
+    {
+        before_value();
+        put('"');
+        if (find_unsafe(value) != std::string_view::npos)
+        {
+            put_escaped(value);
+        }
+        else if (m_sink && value.size() >= m_flush_threshold)
+        {
+            //长字符串不进缓冲区，与已缓冲的内容一起聚集写出
+            std::string_view parts[2] = {m_buf, value};
+            m_sink->writev(parts, 2);
+            m_buf.clear();
+        }
+        else
+        {
+            put(value);
+        }
+        put('"');
+    }
+
+    void Writer::put_escaped(std::string_view value)
+    {
+        if (m_sink == nullptr)
+        {
+            escape(value, m_buf);
+            return;
+        }
+        //转义按字节进行，可以在任意位置切分；每块转义后按需写出，缓冲区最多超出阈值一块转义后的长度
+        constexpr size_t k_chunk = 4096;
+        for (size_t pos = 0; pos < value.size(); pos += k_chunk)
+        {
+            escape(value.substr(pos, k_chunk), m_buf);
+            if (m_buf.size() >= m_flush_threshold)
+                flush_buffer();
+        }
+    }
+
+    void Writer::raw_value(std::string_view json)
+    {
+        before_value();
+        put(json);
+    }
+
+    void Writer::start_object()
+    {
+        before_value();
+        put('{');
+        m_levels.push_back({true, true});
+    }
+
+    void Writer::key(std::string_view key)
+    {
+        before_key();
+        put('"');
+        if (find_unsafe(key) != std::string_view::npos)
+            put_escaped(key);
+        else
+            put(key);
+        put(m_options.pretty ? std::string_view("\": ") : std::string_view("\":"));
+        m_after_key = true;
+    }
+
+    void Writer::raw_key(std::string_view quoted_key)
+    {
+        before_key();
+        put(quoted_key);
+        put(m_options.pretty ? std::string_view(": ") : std::string_view(":"));
+        m_after_key = true;
+    }
+
+    void Writer::before_key()
+    {
+        if (m_sink && m_buf.size() >= m_flush_threshold)
+            flush_buffer();
+        Level &level = m_levels.back();
+        if (!level.first)
+            put(',');
+        level.first = false;
+        if (m_options.pretty)
+            newline_indent(m_levels.size());
+    }
+
+    void Writer::end_object()
+    {
+        const bool empty = m_levels.back().first;
+        m_levels.pop_back();
+        if (m_options.pretty && !empty)
+            newline_indent(m_levels.size());
+        put('}');
+    }
+
+    void Writer::start_array()
+    {
+        before_value();
+        put('[');
+        m_levels.push_back({false, true});
+    }
+
+    void Writer::end_array()
+    {
+        const bool empty = m_levels.back().first;
+        m_levels.pop_back();
+        if (m_options.pretty && !empty)
+            newline_indent(m_levels.size());
+        put(']');
+    }
+
+    void Writer::before_value()
+    {
+        if (m_sink && m_buf.size() >= m_flush_threshold)
+            flush_buffer();
+        if (m_after_key) //冒号已经由key()写入
+        {
+            m_after_key = false;
+            return;
+        }
+        if (m_levels.empty())
+            return;
+        Level &level = m_levels.back();
+        if (!level.first)
+            put(',');
+        level.first = false;
+        if (m_options.pretty)
+            newline_indent(m_levels.size());
+    }
+
+    void Writer::newline_indent(size_t depth)
+    {
+        put('\n');
+        m_buf.append(depth * m_options.indent, ' ');
+    }
+
+    size_t Writer::estimate_size(JsonObject &obj)
+    {
+        switch (obj.get_type())
+        {
+        case T_NULL:
+            return 4;
+        case T_BOOL:
+            return 5;
+        case T_INT:
+        case T_UINT:
+            return 10;
+        case T_DOUBLE:
+            return 20;
+        case T_STRING:
+            return obj.get_view().size() + 2;
+        case T_LIST:
+        {
+            auto &list = obj.get_value<list_t>();
+            size_t size = 2 + list.size();
+            for (auto &item : list)
+                size += estimate_size(item);
+            return size;
+        }
+        case T_DICT:
+        {
+            auto &dict = obj.get_value<dict_t>();
+            size_t size = 2;
+            for (auto &item : dict)
+                size += item.first.size() + 4 + estimate_size(item.second);
+            return size;
+        }
+        }
+        return 0;
+    }
+
+    void write_to(Sink &sink, JsonObject &obj, const WriteOptions &options)
+    {
+        Writer writer(sink, options);
+        writer.write(obj);
+        writer.flush();
+    }
+} // namespace fjson
\ No newline at end of file
@@ -0,0 +1,106 @@
+#ifndef MAGNUM_FJSON_WRITER_H__
+#define MAGNUM_FJSON_WRITER_H__
+
+#include "json_object.h"
+#include "sink.h"
+
+namespace fjson
+{
+    struct WriteOptions
+    {
+        bool pretty = false; //是否换行缩进
+        int indent = 4;      //缩进空格数，只在pretty模式下生效
+    };
+
+    /**
+     * @brief
+     * 序列化到一块可增长的缓冲区，逗号、冒号和缩进由写入器根据嵌套状态自动处理。
+     * 既可以直接写入整棵JsonObject，也可以通过start_object/key/...逐个事件写入。
+     * 整数使用std::to_chars，浮点数使用to_chars的最短可往返表示。
+     * 字符串与键按需转义，不含特殊字符时整段拷贝。
+     * 绑定Sink时缓冲区超过flush_threshold就写出一次，峰值内存与文档大小无关，
+     * 长字符串与缓冲区通过一次writev写出而不再拷贝；写完后需调用flush()。
+     */
+    class Writer
+    {
+    public:
+        explicit Writer(WriteOptions options = WriteOptions());
+        explicit Writer(Sink &sink, WriteOptions options = WriteOptions(), size_t flush_threshold = 64 << 10);
+
+        void write(JsonObject &obj);
+
+        void null();
+        void boolean(bool value);
+        void integer(int64_t value);
+        void unsigned_integer(uint64_t value);
+        void number(double value);
+        void string(std::string_view value);
+        //写入已经是合法json的片段，作为一个值
+        void raw_value(std::string_view json);
+
+        void start_object();
+        void key(std::string_view key);
+        //写入已经带引号并转义好的键，用于编译期生成的字段名
+        void raw_key(std::string_view quoted_key);
+        void end_object();
+        void start_array();
+        void end_array();
+
+        void reserve(size_t size)
+        {
+            m_buf.reserve(size);
+        }
+
+        std::string &buffer()
+        {
+            return m_buf;
+        }
+
+        std::string take()
+        {
+            return std::move(m_buf);
+        }
+
+        //把缓冲区剩余内容写到sink并刷新，没有sink时什么都不做
+        void flush();
+
+        //粗略估计序列化后的长度，用于预先分配缓冲区
+        static size_t estimate_size(JsonObject &obj);
+
+    private:
+        struct Level
+        {
+            bool is_object;
+            bool first;
+        };
+
+        //写入一个值之前的分隔符与缩进
+        void before_value();
+        void before_key();
+        void newline_indent(size_t depth);
+        void flush_buffer();
+        //转义后追加到缓冲区，绑定sink时分块转义并及时写出
+        void put_escaped(std::string_view value);
+        void put(char ch)
+        {
+            m_buf.push_back(ch);
+        }
+        void put(std::string_view str)
+        {
+            m_buf.append(str.data(), str.size());
+        }
+
+    private:
+        std::string m_buf;
+        WriteOptions m_options;
+        std::vector<Level> m_levels;
+        bool m_after_key = false;
+        Sink *m_sink = nullptr;
+        size_t m_flush_threshold = 0;
+    };
+
+    //流式写出整棵树并刷新sink
+    void write_to(Sink &sink, JsonObject &obj, const WriteOptions &options = WriteOptions());
+} // namespace fjson
+
+#endif //! MAGNUM_FJSON_WRITER_H__
\ No newline at end of file
@@ -0,0 +1,110 @@
+#ifndef MAGNUM_THREADPOOL_THREADPOOL_H__
+#define MAGNUM_THREADPOOL_THREADPOOL_H__
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "../threadsafe/queue.h"
+
+namespace threadpool
+{
+    /**
+     * @brief
+     * 固定大小的线程池，任务通过threadsafe::Queue分发，
+     * 工作线程阻塞等待任务，析构时关闭队列，工作线程执行完剩余的任务后退出
+     */
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency())
+        {
+            if (thread_count == 0)
+                thread_count = 1;
+            m_threads.reserve(thread_count);
+            try
+            {
+                for (size_t i = 0; i < thread_count; i++)
+                {
+                    m_threads.emplace_back(&ThreadPool::worker_thread, this);
+                }
+            }
+            catch (...)
+            {
+                //已启动的线程仍可join，不回收就析构vector会调用std::terminate
+                shutdown();
+                throw;
+            }
+        }
+
+        ThreadPool(const ThreadPool &other) = delete;
+        ThreadPool &operator=(const ThreadPool &other) = delete;
+
+        ~ThreadPool()
+        {
+            shutdown();
+        }
+
+        template <class F>
+        std::future<typename std::invoke_result<F>::type> submit(F f)
+        {
+            using result_type = typename std::invoke_result<F>::type;
+            //std::function要求可拷贝，packaged_task只能移动，借助shared_ptr包装
+            auto task = std::make_shared<std::packaged_task<result_type()>>(std::move(f));
+            std::future<result_type> res = task->get_future();
+            m_work_queue.push([task]
+                              { (*task)(); });
+            return res;
+        }
+
+        size_t size() const
+        {
+            return m_threads.size();
+        }
+
+        //当前线程是否是本线程池的工作线程。工作线程提交任务后再等待结果，
+        //所有工作线程都这样阻塞时任务没有线程执行，调用者据此退回在本线程上执行
+        bool in_worker() const
+        {
+            return current() == this;
+        }
+
+    private:
+        static const ThreadPool *&current()
+        {
+            thread_local const ThreadPool *pool = nullptr;
+            return pool;
+        }
+
+        void shutdown()
+        {
+            m_work_queue.close();
+            for (auto &t : m_threads)
+            {
+                t.join();
+            }
+        }
+
+        void worker_thread()
+        {
+            current() = this;
+            while (true)
+            {
+                std::function<void()> task;
+                if (!m_work_queue.wait_pop(task))
+                    return;
+                task();
+            }
+        }
+
+    private:
+        threadsafe::Queue<std::function<void()>> m_work_queue;
+        std::vector<std::thread> m_threads;
+    };
+
+} // namespace threadpool
+
+#endif //! MAGNUM_THREADPOOL_THREADPOOL_H__
\ No newline at end of file
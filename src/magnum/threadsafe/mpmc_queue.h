@@ -0,0 +1,277 @@
+#ifndef MAGNUM_THREADSAFE_MPMC_QUEUE_H__
+#define MAGNUM_THREADSAFE_MPMC_QUEUE_H__
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "spin.h"
+
+namespace threadsafe
+{
+    /**
+     * @brief
+     * 有界无锁多生产者多消费者队列（Vyukov环形队列）。
+     * 容量向上取整为2的幂，每个槽位带一个序号：序号等于入队位置时槽位可写，
+     * 等于入队位置+1时槽位可读。生产者和消费者各自用CAS抢占m_tail/m_head，
+     * 抢到位置后只与该槽位的序号同步，不同槽位之间互不干扰。
+     * 内存布局：m_head、m_tail、几乎只读的m_mask与关闭标志、两个Parker各自独占缓存行，生产者与消费者的
+     * 计数器之间没有伪共享；槽位本身不做填充，按序号与元素紧密排列，int这样的小元素
+     * 每个槽位只占16字节。相邻槽位同时被不同线程访问时可能共享缓存行，这只在队列
+     * 几乎为空或几乎为满时发生，换来的是容量相同时小得多的内存占用。
+     *
+     * 与Queue一样按值传递元素；try_*在满/空时立即返回false，
+     * push/wait_pop在满/空时先自旋退避，仍不成功再挂起等待对方通知，长时间空闲的消费者不占用CPU。
+     * close()之后入队一律失败，阻塞的push返回false；已入队的元素仍可取出，取空后wait_pop返回false。
+     * 与close()同时进行的入队可能成功，这样的元素在wait_pop返回false之后仍可用try_pop取出。
+     *
+     * 抢到槽位之后的构造或移动一旦抛出，槽位永远不会发布，后面的消费者会一直等在这里，
+     * 因此T的移动构造与移动赋值必须是noexcept，由类开头的static_assert在编译期检查；
+     * 可能抛出的构造（如拷贝）在抢槽位之前完成。
+     */
+    template <class T>
+    class MPMCQueue
+    {
+        static_assert(std::is_nothrow_move_constructible<T>::value && std::is_nothrow_move_assignable<T>::value,
+                      "MPMCQueue requires a nothrow move constructor and move assignment");
+
+    public:
+        explicit MPMCQueue(size_t capacity)
+        {
+            if (capacity == 0)
+                throw std::invalid_argument("MPMCQueue capacity must be positive");
+            size_t size = 1;
+            while (size < capacity)
+                size <<= 1;
+            m_mask = size - 1;
+            m_slots.reset(new Slot[size]);
+            for (size_t i = 0; i < size; i++)
+                m_slots[i].seq.store(i, std::memory_order_relaxed);
+        }
+
+        MPMCQueue(const MPMCQueue &other) = delete;
+        MPMCQueue &operator=(const MPMCQueue &other) = delete;
+
+        ~MPMCQueue()
+        {
+            //析构时不再有并发访问，直接销毁[head, tail)之间剩余的元素
+            const size_t tail = m_tail.load(std::memory_order_relaxed);
+            for (size_t pos = m_head.load(std::memory_order_relaxed); pos != tail; pos++)
+                m_slots[pos & m_mask].ptr()->~T();
+        }
+
+        //队列已满或已关闭时返回false
+        template <class... Args>
+        bool try_emplace(Args &&...args)
+        {
+            if (closed() || !emplace_slot(std::forward<Args>(args)...))
+                return false;
+            m_not_empty.notify_one();
+            return true;
+        }
+
+        bool try_push(const T &value)
+        {
+            return try_emplace(value);
+        }
+
+        //失败时value保持不变
+        bool try_push(T &&value)
+        {
+            return try_emplace(std::move(value));
+        }
+
+        //阻塞直到入队；队列关闭后返回false，元素被丢弃
+        bool push(T new_value)
+        {
+            Backoff backoff;
+            while (true)
+            {
+                if (closed())
+                    return false;
+                if (emplace_slot(std::move(new_value)))
+                    break;
+                if (backoff.exhausted())
+                {
+                    bool pushed = false;
+                    m_not_full.wait([&]
+                                    { return closed() || (pushed = emplace_slot(std::move(new_value))); });
+                    if (!pushed)
+                        return false;
+                    break;
+                }
+                backoff.pause();
+            }
+            m_not_empty.notify_one();
+            return true;
+        }
+
+        bool try_pop(T &value)
+        {
+            if (!pop_slot(value))
+                return false;
+            m_not_full.notify_one();
+            return true;
+        }
+
+        //阻塞直到取到元素；队列关闭且已取空时返回false
+        bool wait_pop(T &value)
+        {
+            Backoff backoff;
+            while (!pop_slot(value))
+            {
+                //看到关闭后再取一次，关闭之前发布的元素不会漏掉
+                if (closed())
+                {
+                    if (pop_slot(value))
+                        break;
+                    return false;
+                }
+                if (backoff.exhausted())
+                {
+                    bool popped = false;
+                    m_not_empty.wait([&]
+                                     { return (popped = pop_slot(value)) || closed(); });
+                    if (!popped && !pop_slot(value))
+                        return false;
+                    break;
+                }
+                backoff.pause();
+            }
+            m_not_full.notify_one();
+            return true;
+        }
+
+        //关闭队列并唤醒所有阻塞的push与wait_pop
+        void close()
+        {
+            m_closed.store(true, std::memory_order_release);
+            m_not_empty.notify_all();
+            m_not_full.notify_all();
+        }
+
+        bool closed() const
+        {
+            return m_closed.load(std::memory_order_acquire);
+        }
+
+        //并发修改时只是一个瞬时的近似值
+        size_t size() const
+        {
+            const size_t tail = m_tail.load(std::memory_order_acquire);
+            const size_t head = m_head.load(std::memory_order_acquire);
+            return tail > head ? tail - head : 0;
+        }
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        size_t capacity() const
+        {
+            return m_mask + 1;
+        }
+
+    private:
+        //以下两个函数不发通知，可以在Parker持锁时调用；通知由调用者在锁外发出，
+        //否则入队方持m_not_full的锁去通知m_not_empty、出队方反过来，两把锁会互相等待
+
+        template <class... Args>
+        bool emplace_slot(Args &&...args)
+        {
+            if constexpr (!std::is_nothrow_constructible<T, Args &&...>::value)
+            {
+                //构造可能抛出时先在队列之外构造好，抢到槽位后只做不抛出的移动
+                T tmp(std::forward<Args>(args)...);
+                return emplace_slot(std::move(tmp));
+            }
+            else
+            {
+                size_t pos = m_tail.load(std::memory_order_relaxed);
+                while (true)
+                {
+                    Slot &slot = m_slots[pos & m_mask];
+                    const size_t seq = slot.seq.load(std::memory_order_acquire);
+                    const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq - pos);
+                    if (diff == 0)
+                    {
+                        if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        {
+                            ::new (static_cast<void *>(slot.storage)) T(std::forward<Args>(args)...);
+                            slot.seq.store(pos + 1, std::memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if (diff < 0)
+                    {
+                        //槽位还没被上一轮的消费者取走，队列已满
+                        return false;
+                    }
+                    else
+                    {
+                        pos = m_tail.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+        }
+
+        bool pop_slot(T &value)
+        {
+            size_t pos = m_head.load(std::memory_order_relaxed);
+            while (true)
+            {
+                Slot &slot = m_slots[pos & m_mask];
+                const size_t seq = slot.seq.load(std::memory_order_acquire);
+                const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+                if (diff == 0)
+                {
+                    if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        T *item = slot.ptr();
+                        value = std::move(*item);
+                        item->~T();
+                        //留给下一轮（pos + 容量）的生产者
+                        slot.seq.store(pos + m_mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = m_head.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        //不按缓存行对齐，见类说明中的内存布局
+        struct Slot
+        {
+            std::atomic<size_t> seq;
+            alignas(T) unsigned char storage[sizeof(T)];
+
+            T *ptr()
+            {
+                return std::launder(reinterpret_cast<T *>(storage));
+            }
+        };
+
+        alignas(k_cache_line) std::atomic<size_t> m_head{0};
+        alignas(k_cache_line) std::atomic<size_t> m_tail{0};
+        alignas(k_cache_line) size_t m_mask = 0;
+        std::unique_ptr<Slot[]> m_slots;
+        std::atomic<bool> m_closed{false}; //只在close()时写一次
+        //等待者计数每次入队出队都会读取，与只读的m_mask分开
+        alignas(k_cache_line) Parker m_not_empty;
+        alignas(k_cache_line) Parker m_not_full;
+    };
+} // namespace threadsafe
+
+#endif //! MAGNUM_THREADSAFE_MPMC_QUEUE_H__
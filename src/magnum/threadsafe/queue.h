@@ -1,9 +1,19 @@
 #ifndef MAGNUM_THREADSAFE_QUEUE_H__
 #define MAGNUM_THREADSAFE_QUEUE_H__
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <new>
 #include <mutex>
 #include <queue>
 #include <condition_variable>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+#include "spin.h"
 
 namespace threadsafe
 {
@@ -12,33 +22,48 @@ namespace threadsafe
     class Queue
     {
     public:
+        //关闭后元素被丢弃，需要知道是否入队时使用try_push
         void push(T new_value)
+        {
+            try_push(std::move(new_value));
+        }
+
+        //关闭后不再入队，返回false
+        bool try_push(T new_value)
         {
             // std::lock_guard<std::mutex> lk(m_mtx);
             // m_queue.push(new_value);
             // m_cond.notify_one();
 
-            auto data = std::make_shared(std::move(new_value));
+            auto data = std::make_shared<T>(std::move(new_value));
             std::lock_guard<std::mutex> lk(m_mtx);
+            if (m_closed)
+                return false;
             m_queue.push(data);
-            m_cond.notify_one();
+            notify(1);
+            return true;
         }
 
-        void wait_pop(T &value)
+        //阻塞直到取到元素；队列关闭且已取空时返回false
+        bool wait_pop(T &value)
         {
             std::unique_lock<std::mutex> lk(m_mtx);
-            m_cond.wait(lk, [this]
-                        { return !m_queue.empty(); });
+            wait_ready(lk);
+            if (m_queue.empty())
+                return false;
             // value = std::move(m_queue.front());
             value = std::move(*m_queue.front());
             m_queue.pop();
+            return true;
         }
 
+        //队列关闭且已取空时返回空指针
         std::shared_ptr<T> wait_pop()
         {
             std::unique_lock<std::mutex> lk(m_mtx);
-            m_cond.wait(lk, [this]
-                        { return !m_queue.empty(); });
+            wait_ready(lk);
+            if (m_queue.empty())
+                return std::shared_ptr<T>();
             // std::shared_ptr<T> res(
             //     std::make_shared<T>(std::move(m_queue.front())));
             std::shared_ptr<T> res = m_queue.front();
@@ -46,6 +71,24 @@ namespace threadsafe
             return res;
         }
 
+        //超时或队列关闭且已取空时返回false
+        template <class Rep, class Period>
+        bool wait_pop_for(T &value, const std::chrono::duration<Rep, Period> &timeout)
+        {
+            return wait_pop_until(value, std::chrono::steady_clock::now() + timeout);
+        }
+
+        template <class Clock, class Duration>
+        bool wait_pop_until(T &value, const std::chrono::time_point<Clock, Duration> &deadline)
+        {
+            std::unique_lock<std::mutex> lk(m_mtx);
+            if (!wait_ready(lk, &deadline))
+                return false;
+            value = std::move(*m_queue.front());
+            m_queue.pop();
+            return true;
+        }
+
         bool try_pop(T &value)
         {
             std::lock_guard<std::mutex> lk(m_mtx);
@@ -73,76 +116,553 @@ namespace threadsafe
             return res;
         }
 
+        /**
+         * 批量入队[first, last)：shared_ptr在锁外构造，整批只加一次锁，最多唤醒元素个数的等待者。
+         * 元素由*first构造，传入std::make_move_iterator即可移动而不是拷贝。关闭后整批丢弃，返回false
+         */
+        template <class It>
+        bool push_bulk(It first, It last)
+        {
+            std::vector<std::shared_ptr<T>> batch;
+            for (; first != last; ++first)
+                batch.push_back(std::make_shared<T>(*first));
+            std::lock_guard<std::mutex> lk(m_mtx);
+            if (m_closed)
+                return false;
+            for (auto &data : batch)
+                m_queue.push(std::move(data));
+            notify(batch.size());
+            return true;
+        }
+
+        //右值容器中的元素被移动入队
+        template <class Range>
+        bool push_bulk(Range &&range)
+        {
+            if constexpr (std::is_lvalue_reference<Range>::value)
+                return push_bulk(std::begin(range), std::end(range));
+            else
+                return push_bulk(std::make_move_iterator(std::begin(range)), std::make_move_iterator(std::end(range)));
+        }
+
+        //最多出队max个元素依次写入out，返回实际出队的个数
+        template <class OutIt>
+        size_t try_pop_bulk(OutIt out, size_t max)
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            return pop_locked(out, max);
+        }
+
+        //阻塞直到至少有一个元素，再最多出队max个；队列关闭且已取空时返回0
+        template <class OutIt>
+        size_t wait_pop_bulk(OutIt out, size_t max)
+        {
+            if (max == 0)
+                return 0;
+            std::unique_lock<std::mutex> lk(m_mtx);
+            wait_ready(lk);
+            return pop_locked(out, max);
+        }
+
+        //取走当前所有元素：锁内只交换容器，元素在锁外移动；移动抛出时剩余元素随taken释放
+        std::vector<T> drain_all()
+        {
+            std::queue<std::shared_ptr<T>> taken;
+            {
+                std::lock_guard<std::mutex> lk(m_mtx);
+                taken.swap(m_queue);
+            }
+            std::vector<T> res;
+            res.reserve(taken.size());
+            for (; !taken.empty(); taken.pop())
+                res.push_back(std::move(*taken.front()));
+            return res;
+        }
+
         bool empty() const
         {
             std::lock_guard<std::mutex> lk(m_mtx);
             return m_queue.empty();
         }
 
+        /**
+         * 关闭队列并唤醒所有等待者。之后push丢弃元素，try_push与push_bulk返回false，已入队的元素仍可取出，
+         * 取空后各种wait_pop立即返回空结果，不再阻塞
+         */
+        void close()
+        {
+            {
+                std::lock_guard<std::mutex> lk(m_mtx);
+                m_closed = true;
+            }
+            m_cond.notify_all();
+        }
+
+        bool closed() const
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            return m_closed;
+        }
+
     private:
         mutable std::mutex m_mtx;
         std::queue<std::shared_ptr<T>> m_queue;
         std::condition_variable m_cond;
+        size_t m_waiters = 0; //阻塞在m_cond上的线程数，m_mtx保护
+        bool m_closed = false;
+
+    private:
+        /**
+         * 调用时持有m_mtx。每个元素最多唤醒一个等待者，没有等待者时不通知；
+         * 已被唤醒但还没拿到锁的线程仍在计数中，多出的notify_one会落到其他等待者上或什么都不做
+         */
+        void notify(size_t count)
+        {
+            for (size_t i = std::min(count, m_waiters); i > 0; i--)
+                m_cond.notify_one();
+        }
+
+        /**
+         * 调用时持有m_mtx，等到队列非空、队列关闭或超过deadline（为空时不限时），
+         * 返回队列是否非空
+         */
+        template <class TimePoint = std::chrono::steady_clock::time_point>
+        bool wait_ready(std::unique_lock<std::mutex> &lk, const TimePoint *deadline = nullptr)
+        {
+            auto ready = [this]
+            { return !m_queue.empty() || m_closed; };
+            m_waiters++;
+            if (deadline)
+                m_cond.wait_until(lk, *deadline, ready);
+            else
+                m_cond.wait(lk, ready);
+            m_waiters--;
+            return !m_queue.empty();
+        }
+
+        //调用时持有m_mtx
+        template <class OutIt>
+        size_t pop_locked(OutIt &out, size_t max)
+        {
+            size_t n = 0;
+            for (; n < max && !m_queue.empty(); n++, m_queue.pop())
+            {
+                *out = std::move(*m_queue.front());
+                ++out;
+            }
+            return n;
+        }
     };
 
+    /**
+     * @brief
+     * 头尾分离加锁的链表队列，生产者只锁m_tail_mtx，消费者只锁m_head_mtx。
+     * 节点直接内嵌T，出队后的节点不释放而是回收：消费者侧先攒在m_recycled里，
+     * 攒满一批后在m_free_mtx下挂到共享空闲链表，生产者侧用完m_spare时再整条取走，
+     * 稳态下push/pop既不分配内存，也很少碰到m_free_mtx。
+     * 共享空闲链表最多保留k_max_free个节点，突发流量过后多余的节点直接释放。
+     */
     template <class T>
     class queue
     {
     public:
-        queue() : m_head(new node), m_tail(m_head.get()){};
+        queue() : m_head(new node), m_tail(m_head){};
 
         queue(const queue &other) = delete;
 
         queue &operator=(const queue &other) = delete;
 
+        ~queue()
+        {
+            //逐个释放，积压很多元素时也不会像unique_ptr链那样递归析构爆栈
+            while (m_head != m_tail)
+            {
+                node *next = m_head->next_;
+                m_head->value()->~T();
+                delete m_head;
+                m_head = next;
+            }
+            delete m_tail;
+            free_chain(m_spare);
+            free_chain(m_recycled);
+            free_chain(m_shared_free);
+        }
+
         std::shared_ptr<T> try_pop()
         {
-            std::unique_ptr<node> old_head = pop_head();
-            return old_head ? old_head->data_ : std::shared_ptr<T>();
+            std::shared_ptr<T> res;
+            pop_head([&](T &item)
+                     { res = std::make_shared<T>(std::move(item)); });
+            return res;
+        }
+
+        //不经过shared_ptr，没有任何分配
+        bool try_pop(T &value)
+        {
+            return pop_head([&](T &item)
+                            { value = std::move(item); });
+        }
+
+        //阻塞直到取到元素；队列关闭且已取空时返回false
+        bool wait_pop(T &value)
+        {
+            std::unique_lock<std::mutex> head_lock(m_head_mtx);
+            if (!wait_for_data(head_lock))
+                return false;
+            return pop_locked(get_tail(), 1, [&](T &item)
+                              { value = std::move(item); }) == 1;
+        }
+
+        //队列关闭且已取空时返回空指针
+        std::shared_ptr<T> wait_pop()
+        {
+            std::shared_ptr<T> res;
+            std::unique_lock<std::mutex> head_lock(m_head_mtx);
+            if (wait_for_data(head_lock))
+                pop_locked(get_tail(), 1, [&](T &item)
+                           { res = std::make_shared<T>(std::move(item)); });
+            return res;
+        }
+
+        //超时或队列关闭且已取空时返回false
+        template <class Rep, class Period>
+        bool wait_pop_for(T &value, const std::chrono::duration<Rep, Period> &timeout)
+        {
+            return wait_pop_until(value, std::chrono::steady_clock::now() + timeout);
+        }
+
+        template <class Clock, class Duration>
+        bool wait_pop_until(T &value, const std::chrono::time_point<Clock, Duration> &deadline)
+        {
+            std::unique_lock<std::mutex> head_lock(m_head_mtx);
+            if (!wait_for_data(head_lock, &deadline))
+                return false;
+            return pop_locked(get_tail(), 1, [&](T &item)
+                              { value = std::move(item); }) == 1;
         }
 
+        //关闭后元素被丢弃，需要知道是否入队时使用try_push
         void push(T new_value)
         {
-            std::shared_ptr<T> new_data(
-                std::make_shared<T>(std::move(new_value)));
-            std::unique_ptr<node> p(new node);
-            node *const new_tail = p.get();
+            try_push(std::move(new_value));
+        }
 
-            std::lock_guard<std::mutex> tail_lock(m_tail_mtx);
-            m_tail->data_ = new_data;
-            m_tail->next_ = std::move(p);
-            m_tail = new_tail;
+        //关闭后不再入队，返回false
+        bool try_push(T new_value)
+        {
+            {
+                std::lock_guard<std::mutex> tail_lock(m_tail_mtx);
+                if (m_closed.load(std::memory_order_relaxed))
+                    return false;
+                append(std::move(new_value));
+            }
+            wake(1);
+            return true;
+        }
+
+        /**
+         * 批量入队[first, last)，整批只加一次尾锁，最多唤醒元素个数的等待者。
+         * 元素由*first构造，传入std::make_move_iterator即可移动而不是拷贝。关闭后整批丢弃，返回false
+         */
+        template <class It>
+        bool push_bulk(It first, It last)
+        {
+            size_t count = 0;
+            {
+                std::lock_guard<std::mutex> tail_lock(m_tail_mtx);
+                if (m_closed.load(std::memory_order_relaxed))
+                    return false;
+                for (; first != last; ++first, ++count)
+                    append(*first);
+            }
+            wake(count);
+            return true;
+        }
+
+        //右值容器中的元素被移动入队
+        template <class Range>
+        bool push_bulk(Range &&range)
+        {
+            if constexpr (std::is_lvalue_reference<Range>::value)
+                return push_bulk(std::begin(range), std::end(range));
+            else
+                return push_bulk(std::make_move_iterator(std::begin(range)), std::make_move_iterator(std::end(range)));
+        }
+
+        //最多出队max个元素依次写入out，返回实际出队的个数；整批只读一次尾指针
+        template <class OutIt>
+        size_t try_pop_bulk(OutIt out, size_t max)
+        {
+            std::lock_guard<std::mutex> head_lock(m_head_mtx);
+            return pop_locked(get_tail(), max, [&](T &item)
+                              { *out = std::move(item); ++out; });
+        }
+
+        //阻塞直到至少有一个元素，再最多出队max个；队列关闭且已取空时返回0
+        template <class OutIt>
+        size_t wait_pop_bulk(OutIt out, size_t max)
+        {
+            if (max == 0)
+                return 0;
+            std::unique_lock<std::mutex> head_lock(m_head_mtx);
+            if (!wait_for_data(head_lock))
+                return 0;
+            return pop_locked(get_tail(), max, [&](T &item)
+                              { *out = std::move(item); ++out; });
+        }
+
+        //取走当前所有元素：锁内只摘下整条链，元素在锁外移动，最后一次性回收节点
+        std::vector<T> drain_all()
+        {
+            node *first;
+            node *last;
+            {
+                std::lock_guard<std::mutex> head_lock(m_head_mtx);
+                first = m_head;
+                last = get_tail();
+                m_head = last;
+            }
+            std::vector<T> res;
+            node *n = first;
+            try
+            {
+                size_t count = 0;
+                for (node *p = first; p != last; p = p->next_)
+                    count++;
+                res.reserve(count);
+                for (; n != last; n = n->next_)
+                {
+                    T *item = n->value();
+                    res.push_back(std::move(*item));
+                    item->~T();
+                }
+            }
+            catch (...)
+            {
+                //链已从队列摘下，无法放回：还没取出的元素就地销毁，节点照常回收后再抛出
+                for (; n != last; n = n->next_)
+                    n->value()->~T();
+                recycle_chain(first, last);
+                throw;
+            }
+            recycle_chain(first, last);
+            return res;
+        }
+
+        /**
+         * 关闭队列并唤醒所有等待者。之后push丢弃元素，try_push与push_bulk返回false，已入队的元素仍可取出，
+         * 取空后各种wait_pop立即返回空结果，不再阻塞
+         */
+        void close()
+        {
+            {
+                std::lock_guard<std::mutex> tail_lock(m_tail_mtx);
+                m_closed.store(true);
+            }
+            //与wake相同，先拿一次头锁，避免等待者检查完状态、尚未进入wait时错过通知
+            {
+                std::lock_guard<std::mutex> head_lock(m_head_mtx);
+            }
+            m_cond.notify_all();
+        }
+
+        bool closed() const
+        {
+            return m_closed.load();
         }
 
     private:
         struct node
         {
-            std::shared_ptr<T> data_;
-            std::unique_ptr<node> next_; // 自动析构，但数据量较大时会爆栈，需要修改
+            node *next_ = nullptr;
+            alignas(T) unsigned char storage_[sizeof(T)];
+
+            T *value()
+            {
+                return std::launder(reinterpret_cast<T *>(storage_));
+            }
         };
 
-        std::mutex m_head_mtx;
-        std::unique_ptr<node> m_head;
-        std::mutex m_tail_mtx;
+        static constexpr size_t k_recycle_batch = 64;
+        static constexpr size_t k_max_free = 4096;
+
+        //消费者侧，m_head_mtx保护
+        alignas(k_cache_line) std::mutex m_head_mtx;
+        node *m_head;
+        node *m_recycled = nullptr;
+        node *m_recycled_last = nullptr;
+        size_t m_recycled_count = 0;
+
+        //生产者侧，m_tail_mtx保护
+        alignas(k_cache_line) std::mutex m_tail_mtx;
         node *m_tail;
+        node *m_spare = nullptr;
+
+        //两侧交换节点用，m_free_mtx保护；m_shared_count可以不加锁读，为0时生产者不必加锁
+        alignas(k_cache_line) std::mutex m_free_mtx;
+        node *m_shared_free = nullptr;
+        std::atomic<size_t> m_shared_count{0};
+
+        //与m_head_mtx配合使用；m_waiters为0时生产者不必碰头锁
+        std::condition_variable m_cond;
+        std::atomic<size_t> m_waiters{0};
+        std::atomic<bool> m_closed{false};
 
     private:
+        static void free_chain(node *n)
+        {
+            while (n)
+            {
+                node *next = n->next_;
+                delete n;
+                n = next;
+            }
+        }
+
         node *get_tail()
         {
             std::lock_guard<std::mutex> tail_lock(m_tail_mtx);
             return m_tail;
         }
 
-        std::unique_ptr<node> pop_head()
+        //调用时持有m_tail_mtx
+        node *acquire_node()
         {
+            if (!m_spare && m_shared_count.load(std::memory_order_relaxed) != 0)
+            {
+                std::lock_guard<std::mutex> free_lock(m_free_mtx);
+                m_spare = m_shared_free;
+                m_shared_free = nullptr;
+                m_shared_count.store(0, std::memory_order_relaxed);
+            }
+            if (!m_spare)
+                return new node;
+            node *n = m_spare;
+            m_spare = n->next_;
+            n->next_ = nullptr;
+            return n;
+        }
+
+        //调用时持有m_head_mtx
+        void recycle(node *n)
+        {
+            n->next_ = m_recycled;
+            m_recycled = n;
+            if (!m_recycled_last)
+                m_recycled_last = n;
+            if (++m_recycled_count < k_recycle_batch)
+                return;
+
+            node *const batch = m_recycled;
+            node *const last = m_recycled_last;
+            m_recycled = m_recycled_last = nullptr;
+            m_recycled_count = 0;
+            {
+                std::lock_guard<std::mutex> free_lock(m_free_mtx);
+                const size_t shared = m_shared_count.load(std::memory_order_relaxed);
+                if (shared < k_max_free)
+                {
+                    last->next_ = m_shared_free;
+                    m_shared_free = batch;
+                    m_shared_count.store(shared + k_recycle_batch, std::memory_order_relaxed);
+                    return;
+                }
+            }
+            free_chain(batch);
+        }
+
+        //回收[first, last)中已经销毁了元素的节点
+        void recycle_chain(node *first, node *last)
+        {
+            if (first == last)
+                return;
             std::lock_guard<std::mutex> head_lock(m_head_mtx);
-            if (m_head.get() == get_tail())
+            while (first != last)
+            {
+                node *next = first->next_;
+                recycle(first);
+                first = next;
+            }
+        }
+
+        //调用时持有m_tail_mtx，在尾部的哑节点上构造元素并挂上新的哑节点
+        template <class U>
+        void append(U &&value)
+        {
+            node *const new_tail = acquire_node();
+            try
+            {
+                ::new (static_cast<void *>(m_tail->storage_)) T(std::forward<U>(value));
+            }
+            catch (...)
+            {
+                new_tail->next_ = m_spare;
+                m_spare = new_tail;
+                throw;
+            }
+            m_tail->next_ = new_tail;
+            m_tail = new_tail;
+        }
+
+        /**
+         * 在尾锁外调用。等待者在头锁下检查队列为空后才进入wait，
+         * 先拿一次头锁再通知，保证通知不会落在检查与wait之间而丢失
+         */
+        void wake(size_t count)
+        {
+            if (count == 0 || m_waiters.load() == 0)
+                return;
+            size_t waiters;
             {
-                return std::unique_ptr<node>(nullptr);
+                std::lock_guard<std::mutex> head_lock(m_head_mtx);
+                waiters = m_waiters.load();
             }
-            std::unique_ptr<node> old_head = std::move(m_head);
-            m_head = std::move(old_head->next_);
-            return old_head;
+            //每个元素最多唤醒一个等待者；之后才登记的等待者在头锁下检查时已能看到新元素
+            for (size_t i = std::min(count, waiters); i > 0; i--)
+                m_cond.notify_one();
+        }
+
+        /**
+         * 调用时持有m_head_mtx，等到队列非空、队列关闭或超过deadline（为空时不限时），
+         * 返回队列是否非空
+         */
+        template <class TimePoint = std::chrono::steady_clock::time_point>
+        bool wait_for_data(std::unique_lock<std::mutex> &head_lock, const TimePoint *deadline = nullptr)
+        {
+            auto ready = [this]
+            { return m_head != get_tail() || m_closed.load(); };
+            //先登记再检查，生产者要么看到登记，要么入队发生在这次检查之前
+            m_waiters.fetch_add(1);
+            if (deadline)
+                m_cond.wait_until(head_lock, *deadline, ready);
+            else
+                m_cond.wait(head_lock, ready);
+            m_waiters.fetch_sub(1);
+            return m_head != get_tail();
+        }
+
+        //调用时持有m_head_mtx，把[m_head, tail)中最多max个元素依次交给consume，并回收节点
+        template <class F>
+        size_t pop_locked(node *tail, size_t max, F &&consume)
+        {
+            size_t n = 0;
+            for (; n < max && m_head != tail; n++)
+            {
+                node *const old_head = m_head;
+                T *item = old_head->value();
+                consume(*item);
+                item->~T();
+                m_head = old_head->next_;
+                recycle(old_head);
+            }
+            return n;
+        }
+
+        template <class F>
+        bool pop_head(F &&consume)
+        {
+            std::lock_guard<std::mutex> head_lock(m_head_mtx);
+            return pop_locked(get_tail(), 1, consume) == 1;
         }
     };
 
@@ -0,0 +1,121 @@
+#ifndef MAGNUM_THREADSAFE_SPIN_H__
+#define MAGNUM_THREADSAFE_SPIN_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+namespace threadsafe
+{
+    //按缓存行对齐，避免生产者与消费者各自修改的下标落在同一缓存行上产生伪共享
+    inline constexpr size_t k_cache_line = 64;
+
+    //自旋等待时提示CPU降低流水线功耗，超线程下把执行资源让给另一个逻辑核
+    inline void cpu_relax()
+    {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+        _mm_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield" ::: "memory");
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    /**
+     * @brief
+     * 指数退避：前几轮自旋次数逐次翻倍，超过上限后改为让出时间片，
+     * 短暂的竞争在用户态内消化，长时间等待时不至于空转占满一个核
+     */
+    class Backoff
+    {
+    public:
+        void pause()
+        {
+            if (m_step <= k_spin_limit)
+            {
+                for (unsigned i = 0; i < (1u << m_step); i++)
+                    cpu_relax();
+                m_step++;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        void reset()
+        {
+            m_step = 0;
+        }
+
+        //自旋阶段是否已经结束，之后再等待就该让出时间片或者挂起
+        bool exhausted() const
+        {
+            return m_step > k_spin_limit;
+        }
+
+    private:
+        static constexpr unsigned k_spin_limit = 6;
+        unsigned m_step = 0;
+    };
+
+    /**
+     * @brief
+     * 自旋退避之后的挂起等待。等待方持锁登记后再检查一次条件，通知方在改变状态后
+     * 检查是否有人登记，两边各用一次seq_cst栅栏，保证不会一方看不到登记而另一方看不到状态。
+     * 没有等待者时notify只多一次栅栏与一次原子读，不碰互斥锁。
+     */
+    class Parker
+    {
+    public:
+        //挂起直到ready()返回true，ready在持锁时调用
+        template <class Pred>
+        void wait(Pred ready)
+        {
+            std::unique_lock<std::mutex> lock(m_mtx);
+            m_waiters.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            m_cond.wait(lock, ready);
+            m_waiters.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        //状态改变之后调用，唤醒一个等待者
+        void notify_one()
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_waiters.load(std::memory_order_relaxed) == 0)
+                return;
+            //等待者从检查条件到进入wait之间一直持锁，先取一次锁保证通知不会落在这个间隙里
+            {
+                std::lock_guard<std::mutex> lock(m_mtx);
+            }
+            m_cond.notify_one();
+        }
+
+        //唤醒所有等待者，用于关闭这类所有等待者都要重新检查条件的状态改变
+        void notify_all()
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_waiters.load(std::memory_order_relaxed) == 0)
+                return;
+            {
+                std::lock_guard<std::mutex> lock(m_mtx);
+            }
+            m_cond.notify_all();
+        }
+
+    private:
+        std::atomic<size_t> m_waiters{0};
+        std::mutex m_mtx;
+        std::condition_variable m_cond;
+    };
+} // namespace threadsafe
+
+#endif //! MAGNUM_THREADSAFE_SPIN_H__
@@ -0,0 +1,285 @@
+#ifndef MAGNUM_THREADSAFE_SPSC_QUEUE_H__
+#define MAGNUM_THREADSAFE_SPSC_QUEUE_H__
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "spin.h"
+
+namespace threadsafe
+{
+    /**
+     * @brief
+     * 有界单生产者单消费者环形队列，只能有一个线程入队、一个线程出队。
+     * m_tail只由生产者写，m_head只由消费者写，两者都是不回绕的计数，元素个数为tail - head。
+     * 生产者在自己的缓存行上缓存一份head，只有缓存值显示队列已满时才去读真实的m_head；
+     * 消费者同样缓存tail，因此稳态下双方几乎不会读对方写的缓存行。
+     * 批量接口一次检查空间、一次发布下标，把同步开销分摊到整批元素上。
+     * 任意线程都可以close()：之后入队一律失败，自旋中的push/push_bulk返回false；
+     * 已入队的元素仍可取出，取空后wait_pop返回false、wait_pop_bulk返回0。
+     */
+    template <class T>
+    class SPSCQueue
+    {
+    public:
+        explicit SPSCQueue(size_t capacity)
+        {
+            if (capacity == 0)
+                throw std::invalid_argument("SPSCQueue capacity must be positive");
+            size_t size = 1;
+            while (size < capacity)
+                size <<= 1;
+            m_mask = size - 1;
+            m_buffer = static_cast<T *>(::operator new(size * sizeof(T), std::align_val_t(alignof(T))));
+        }
+
+        SPSCQueue(const SPSCQueue &other) = delete;
+        SPSCQueue &operator=(const SPSCQueue &other) = delete;
+
+        ~SPSCQueue()
+        {
+            const size_t tail = m_tail.load(std::memory_order_relaxed);
+            for (size_t pos = m_head.load(std::memory_order_relaxed); pos != tail; pos++)
+                m_buffer[pos & m_mask].~T();
+            ::operator delete(m_buffer, std::align_val_t(alignof(T)));
+        }
+
+        //以下入队接口只能由生产者线程调用
+
+        //队列已满或已关闭时返回false
+        template <class... Args>
+        bool try_emplace(Args &&...args)
+        {
+            const size_t tail = m_tail.load(std::memory_order_relaxed);
+            if (closed() || free_slots(tail) == 0)
+                return false;
+            ::new (static_cast<void *>(m_buffer + (tail & m_mask))) T(std::forward<Args>(args)...);
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool try_push(const T &value)
+        {
+            return try_emplace(value);
+        }
+
+        //失败时value保持不变
+        bool try_push(T &&value)
+        {
+            return try_emplace(std::move(value));
+        }
+
+        //阻塞直到入队；队列关闭后返回false，元素被丢弃
+        bool push(T new_value)
+        {
+            Backoff backoff;
+            while (!try_emplace(std::move(new_value)))
+            {
+                if (closed())
+                    return false;
+                backoff.pause();
+            }
+            return true;
+        }
+
+        /**
+         * 尽可能多地入队[first, last)，返回实际入队的个数，first随之前移；关闭后返回0。
+         * 元素由*first构造，传入std::make_move_iterator即可移动而不是拷贝
+         */
+        template <class It>
+        size_t try_push_bulk(It &first, It last)
+        {
+            if (closed())
+                return 0;
+            const size_t tail = m_tail.load(std::memory_order_relaxed);
+            //按这一批实际需要的空位检查缓存，缓存够用时不读对方的缓存行
+            size_t wanted = std::min(capacity(), k_bulk_chunk);
+            if constexpr (std::is_base_of<std::forward_iterator_tag,
+                                          typename std::iterator_traits<It>::iterator_category>::value)
+                wanted = std::min(capacity(), static_cast<size_t>(std::distance(first, last)));
+            const size_t free = free_slots(tail, wanted);
+            size_t n = 0;
+            try
+            {
+                for (; n < free && first != last; ++n, ++first)
+                    ::new (static_cast<void *>(m_buffer + ((tail + n) & m_mask))) T(*first);
+            }
+            catch (...)
+            {
+                //已构造的元素照常发布
+                m_tail.store(tail + n, std::memory_order_release);
+                throw;
+            }
+            m_tail.store(tail + n, std::memory_order_release);
+            return n;
+        }
+
+        //阻塞直到[first, last)全部入队；中途关闭时返回false，已入队的部分保留
+        template <class It>
+        bool push_bulk(It first, It last)
+        {
+            Backoff backoff;
+            while (first != last)
+            {
+                if (try_push_bulk(first, last) != 0)
+                    backoff.reset();
+                else if (closed())
+                    return false;
+                else
+                    backoff.pause();
+            }
+            return true;
+        }
+
+        //以下出队接口只能由消费者线程调用
+
+        bool try_pop(T &value)
+        {
+            const size_t head = m_head.load(std::memory_order_relaxed);
+            if (ready_slots(head) == 0)
+                return false;
+            T &item = m_buffer[head & m_mask];
+            value = std::move(item);
+            item.~T();
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        //阻塞直到取到元素；队列关闭且已取空时返回false
+        bool wait_pop(T &value)
+        {
+            Backoff backoff;
+            while (!try_pop(value))
+            {
+                //看到关闭后再取一次，关闭之前发布的元素不会漏掉
+                if (closed())
+                    return try_pop(value);
+                backoff.pause();
+            }
+            return true;
+        }
+
+        //最多出队max个元素依次写入out，返回实际出队的个数
+        template <class OutIt>
+        size_t try_pop_bulk(OutIt out, size_t max)
+        {
+            const size_t head = m_head.load(std::memory_order_relaxed);
+            const size_t n = std::min(max, ready_slots(head, max));
+            size_t i = 0;
+            try
+            {
+                for (; i < n; i++)
+                {
+                    T &item = m_buffer[(head + i) & m_mask];
+                    *out = std::move(item);
+                    ++out;
+                    item.~T();
+                }
+            }
+            catch (...)
+            {
+                //前i个已经取出并销毁，第i个仍留在队列中
+                m_head.store(head + i, std::memory_order_release);
+                throw;
+            }
+            m_head.store(head + n, std::memory_order_release);
+            return n;
+        }
+
+        //阻塞直到至少有一个元素，再最多出队max个；队列关闭且已取空时返回0
+        template <class OutIt>
+        size_t wait_pop_bulk(OutIt out, size_t max)
+        {
+            if (max == 0)
+                return 0;
+            Backoff backoff;
+            while (ready_slots(m_head.load(std::memory_order_relaxed)) == 0)
+            {
+                if (closed())
+                    return try_pop_bulk(out, max);
+                backoff.pause();
+            }
+            return try_pop_bulk(out, max);
+        }
+
+        //任意线程均可调用
+        void close()
+        {
+            m_closed.store(true, std::memory_order_release);
+        }
+
+        bool closed() const
+        {
+            return m_closed.load(std::memory_order_acquire);
+        }
+
+        //任意线程均可调用，并发修改时只是一个瞬时的近似值
+        size_t size() const
+        {
+            const size_t head = m_head.load(std::memory_order_acquire);
+            const size_t tail = m_tail.load(std::memory_order_acquire);
+            return tail > head ? tail - head : 0;
+        }
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        size_t capacity() const
+        {
+            return m_mask + 1;
+        }
+
+    private:
+        //输入迭代器无法预知个数时，每批按这个数目检查空位
+        static constexpr size_t k_bulk_chunk = 64;
+
+        //生产者侧：缓存值显示的空位少于wanted时才读取真实的head
+        size_t free_slots(size_t tail, size_t wanted = 1)
+        {
+            size_t free = capacity() - (tail - m_head_cache);
+            if (free < wanted)
+            {
+                m_head_cache = m_head.load(std::memory_order_acquire);
+                free = capacity() - (tail - m_head_cache);
+            }
+            return free;
+        }
+
+        //消费者侧：缓存值显示的元素少于wanted时才读取真实的tail
+        size_t ready_slots(size_t head, size_t wanted = 1)
+        {
+            size_t ready = m_tail_cache - head;
+            if (ready < wanted)
+            {
+                m_tail_cache = m_tail.load(std::memory_order_acquire);
+                ready = m_tail_cache - head;
+            }
+            return ready;
+        }
+
+    private:
+        //只读部分，双方共享；m_closed只在close()时写一次
+        alignas(k_cache_line) T *m_buffer = nullptr;
+        size_t m_mask = 0;
+        std::atomic<bool> m_closed{false};
+
+        //消费者独占的缓存行
+        alignas(k_cache_line) std::atomic<size_t> m_head{0};
+        size_t m_tail_cache = 0;
+
+        //生产者独占的缓存行
+        alignas(k_cache_line) std::atomic<size_t> m_tail{0};
+        size_t m_head_cache = 0;
+    };
+} // namespace threadsafe
+
+#endif //! MAGNUM_THREADSAFE_SPSC_QUEUE_H__
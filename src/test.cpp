@@ -1,26 +1,42 @@
+/**
+ * @brief
+ * 运行src/test/下登记的所有用例，失败时返回非零。
+ * 用法：test [NAME]，只运行名称包含NAME的用例。
+ * 部分用例读取test/下的数据，需要在项目根目录运行（xmake run test已设置好）。
+ */
+
+#include <cstring>
 #include <iostream>
 
-#include "magnum/threadsafe/queue.h"
+#include "test/check.h"
 
-int main()
+int main(int argc, char *argv[])
 {
-    threadsafe::queue<int> q;
-
-    for (int i = 0; i < 3; i++)
+    const char *filter = argc > 1 ? argv[1] : nullptr;
+    size_t run = 0;
+    size_t failed = 0;
+    for (const test::Case &c : test::cases())
     {
-        q.push(i);
-    }
-
-    for (int i = 0; i < 5; i++)
-    {
-        auto p = q.try_pop();
-        if (p != nullptr)
+        if (filter && !std::strstr(c.name, filter))
+            continue;
+        run++;
+        test::failures() = 0;
+        try
+        {
+            c.run();
+        }
+        catch (const std::exception &e)
         {
-            std::cout << *p << std::endl;
+            test::fail(c.name, 0, std::string("uncaught exception: ") + e.what());
         }
-        else
+        catch (...)
         {
-            std::cout << "q is empty" << std::endl;
+            test::fail(c.name, 0, "uncaught unknown exception");
         }
+        if (test::failures() != 0)
+            failed++;
+        std::cout << (test::failures() == 0 ? "[ok]   " : "[FAIL] ") << c.name << std::endl;
     }
-}
\ No newline at end of file
+    std::cout << run - failed << "/" << run << " passed" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+#ifndef MAGNUM_TEST_CHECK_H__
+#define MAGNUM_TEST_CHECK_H__
+
+#include <cstddef>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief
+ * 最小的测试框架：TEST_CASE在静态初始化时把用例登记到全局列表，由src/test.cpp的main逐个运行。
+ * CHECK系列失败时只记录文件与行号并继续执行，用例中抛出的未捕获异常也记为一次失败。
+ *
+ * TEST_CASE(queue_fifo)
+ * {
+ *     threadsafe::queue<int> q;
+ *     q.push(1);
+ *     CHECK_EQ(*q.try_pop(), 1);
+ * }
+ */
+namespace test
+{
+    struct Case
+    {
+        const char *name;
+        void (*run)();
+    };
+
+    inline std::vector<Case> &cases()
+    {
+        static std::vector<Case> all;
+        return all;
+    }
+
+    //当前用例的失败次数，main在每个用例开始前清零
+    inline size_t &failures()
+    {
+        static size_t count = 0;
+        return count;
+    }
+
+    inline bool add_case(const char *name, void (*run)())
+    {
+        cases().push_back({name, run});
+        return true;
+    }
+
+    //可以在用例启动的线程中调用
+    inline void fail(const char *file, int line, const std::string &what)
+    {
+        static std::mutex mtx;
+        std::lock_guard<std::mutex> lk(mtx);
+        failures()++;
+        std::cerr << file << ":" << line << ": " << what << std::endl;
+    }
+
+    template <class A, class B>
+    void check_eq(const A &a, const B &b, const char *expr, const char *file, int line)
+    {
+        if (a == b)
+            return;
+        std::ostringstream os;
+        os << "CHECK_EQ(" << expr << ") failed: " << a << " != " << b;
+        fail(file, line, os.str());
+    }
+} // namespace test
+
+#define TEST_CASE(name)                                                   \
+    static void name();                                                   \
+    static const bool name##_registered = test::add_case(#name, &name);   \
+    static void name()
+
+#define CHECK(expr)                                                   \
+    do                                                                \
+    {                                                                 \
+        if (!(expr))                                                  \
+            test::fail(__FILE__, __LINE__, "CHECK(" #expr ") failed"); \
+    } while (0)
+
+#define CHECK_EQ(a, b) test::check_eq((a), (b), #a ", " #b, __FILE__, __LINE__)
+
+//expr必须抛出type（或其子类）
+#define CHECK_THROWS(expr, type)                                                          \
+    do                                                                                    \
+    {                                                                                     \
+        bool thrown_ = false;                                                             \
+        try                                                                               \
+        {                                                                                 \
+            (void)(expr);                                                                 \
+        }                                                                                 \
+        catch (const type &)                                                              \
+        {                                                                                 \
+            thrown_ = true;                                                               \
+        }                                                                                 \
+        catch (...)                                                                       \
+        {                                                                                 \
+        }                                                                                 \
+        if (!thrown_)                                                                     \
+            test::fail(__FILE__, __LINE__, "CHECK_THROWS(" #expr ", " #type ") failed"); \
+    } while (0)
+
+#define CHECK_NOTHROW(expr)                                                                       \
+    do                                                                                            \
+    {                                                                                             \
+        try                                                                                       \
+        {                                                                                         \
+            (void)(expr);                                                                         \
+        }                                                                                         \
+        catch (const std::exception &e_)                                                          \
+        {                                                                                         \
+            test::fail(__FILE__, __LINE__, std::string("CHECK_NOTHROW(" #expr ") threw: ") + e_.what()); \
+        }                                                                                         \
+    } while (0)
+
+#endif //! MAGNUM_TEST_CHECK_H__
@@ -0,0 +1,105 @@
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "magnum/fjson/parser.h"
+
+using namespace fjson;
+
+namespace
+{
+    using Map = FlatMap<int>;
+
+    //成员数跨过线性查找的上限，覆盖下标表的建立与扩容
+    const size_t k_members = Map::k_linear_limit * 40 + 3;
+} // namespace
+
+TEST_CASE(flat_map_beyond_linear_limit)
+{
+    Map map;
+    std::vector<int *> refs;
+    for (size_t i = 0; i < k_members; i++)
+    {
+        auto res = map.try_emplace("key" + std::to_string(i), static_cast<int>(i));
+        CHECK(res.second);
+        refs.push_back(&res.first->second);
+    }
+    CHECK_EQ(map.size(), k_members);
+    CHECK(!map.try_emplace("key5", -1).second);
+    CHECK_EQ(map.at("key5"), 5);
+
+    //插入不移动已有元素，迭代保持插入顺序
+    size_t i = 0;
+    for (auto &item : map)
+    {
+        CHECK_EQ(item.first.view(), "key" + std::to_string(i));
+        CHECK_EQ(&item.second, refs[i]);
+        i++;
+    }
+    for (size_t j = 0; j < k_members; j++)
+        CHECK_EQ(map.index_of("key" + std::to_string(j)), j);
+    CHECK(!map.contains("key" + std::to_string(k_members)));
+    CHECK(map.find("missing") == map.end());
+    CHECK_THROWS(map.at("missing"), std::out_of_range);
+
+    map["new"] = 7;
+    CHECK_EQ(map.size(), k_members + 1);
+    CHECK_EQ(map.index_of("new"), k_members);
+}
+
+TEST_CASE(flat_map_erase_and_copy)
+{
+    Map map;
+    for (size_t i = 0; i < k_members; i++)
+        map.insert_or_assign("k" + std::to_string(i), static_cast<int>(i));
+
+    //删除后下标表重建，后面的元素前移
+    CHECK_EQ(map.erase("k3"), 1u);
+    CHECK_EQ(map.erase("k3"), 0u);
+    CHECK(!map.contains("k3"));
+    CHECK_EQ(map.index_of("k4"), 3u);
+    map.erase(map.begin());
+    CHECK_EQ(map.begin()->first.view(), "k1");
+    CHECK_EQ(map.size(), k_members - 2);
+
+    Map copy(map);
+    CHECK_EQ(copy.size(), map.size());
+    for (auto &item : map)
+        CHECK_EQ(copy.at(item.first), item.second);
+
+    //缩小到线性查找的范围以内仍然可以查找
+    while (copy.size() > Map::k_linear_limit / 2)
+        copy.erase(copy.begin());
+    for (auto &item : copy)
+        CHECK_EQ(copy.index_of(item.first.view()), static_cast<size_t>(&item - &*copy.begin()));
+}
+
+TEST_CASE(flat_map_interned_keys)
+{
+    std::string src = "[";
+    for (size_t i = 0; i < 50; i++)
+    {
+        src += i ? "," : "";
+        src += "{";
+        for (size_t j = 0; j < k_members; j++)
+            src += (j ? ",\"" : "\"") + std::string("field_") + std::to_string(j) + "\":" + std::to_string(j);
+        src += "}";
+    }
+    src += "]";
+
+    //驻留的键在文档之间共享，拷贝出的树不依赖KeyPool
+    JsonObject copy;
+    {
+        Document doc = Parser::parse_document(src, false, true);
+        list_t &items = doc.root().get_value<list_t>();
+        CHECK_EQ(items.size(), 50u);
+        dict_t &first = items[0].get_value<dict_t>();
+        dict_t &last = items[49].get_value<dict_t>();
+        CHECK_EQ(first.size(), k_members);
+        CHECK(first.begin()->first.view().data() == last.begin()->first.view().data());
+        CHECK_EQ(last.at("field_" + std::to_string(k_members - 1)).get_value<int_t>(),
+                 static_cast<int_t>(k_members - 1));
+        copy = doc.root();
+    }
+    CHECK_EQ(copy.to_string(), Parser::from_string(src).to_string());
+}
@@ -0,0 +1,67 @@
+#include <memory_resource>
+#include <string>
+#include <type_traits>
+
+#include "check.h"
+#include "magnum/fjson/parser.h"
+
+using namespace fjson;
+
+namespace
+{
+    //旧的START_TO_JSON / START_FROM_JSON写法
+    struct Legacy
+    {
+        std::string name;
+        int_t age = 0;
+
+        START_TO_JSON
+        to("name") = name;
+        to("age") = age;
+        END_TO_JSON
+
+        START_FROM_JSON
+        name = from("name", string_t);
+        age = from("age", int_t);
+        END_FROM_JSON
+    };
+} // namespace
+
+TEST_CASE(json_object_string_api)
+{
+    static_assert(std::is_same<string_t, std::string>::value, "string_t stays std::string");
+    static_assert(std::is_same<null_t, std::string>::value, "null_t stays available");
+
+    JsonObject obj = Parser::from_string(R"({"k": "a value longer than fourteen bytes", "s": "v"})");
+    std::string k = obj["k"].get_value<string_t>();
+    CHECK_EQ(k, "a value longer than fourteen bytes");
+    CHECK_EQ(obj["s"].get_value<std::string>(), "v");
+    CHECK_EQ(obj["s"].get_value<str_view_t>(), "v");
+    CHECK_THROWS(obj["k"].get_value<int_t>(), std::logic_error);
+
+    //get_value返回拷贝，修改字符串使用Str()
+    obj["s"].Str("changed");
+    CHECK_EQ(obj["s"].get_view(), "changed");
+
+    //pmr字符串构造的节点沿用它的resource
+    std::pmr::monotonic_buffer_resource arena;
+    pmr_string_t text("an arena string longer than fourteen bytes", &arena);
+    JsonObject from_pmr(text);
+    CHECK_EQ(from_pmr.get_view(), text);
+    CHECK(from_pmr.get_value<pmr_string_t>() == text);
+    CHECK_EQ(JsonObject(std::string("std")).to_string(), "\"std\"");
+}
+
+TEST_CASE(json_object_legacy_macros)
+{
+    Legacy in;
+    in.name = "ann";
+    in.age = 7;
+    const std::string json = Parser::ToJSON(in);
+    CHECK_EQ(json, R"({"name":"ann","age":7})");
+    Legacy out = Parser::FromJSON<Legacy>(json);
+    CHECK_EQ(out.name, "ann");
+    CHECK_EQ(out.age, 7);
+    CHECK_EQ(Parser::FromJSON<string_t>(R"("x")"), "x");
+    CHECK_THROWS(Parser::FromJSON<Legacy>("[1]"), std::logic_error);
+}
@@ -0,0 +1,64 @@
+#include <string>
+
+#include "check.h"
+#include "magnum/fjson/lazy_document.h"
+#include "magnum/fjson/parser.h"
+
+using namespace fjson;
+
+namespace
+{
+    const char *k_doc = R"({
+        "users": [
+            {"name": "ann", "tags": ["a", "b"], "skip": {"deep": [[1], {"x": "]}"}]}},
+            {"name": "bob", "age": 17}
+        ],
+        "a/b": 1,
+        "m~n": 2,
+        "quo\"te": 3,
+        "café": 4,
+        "esc\\aped": 5,
+        "": 6
+    })";
+} // namespace
+
+TEST_CASE(lazy_queries)
+{
+    LazyDocument doc{std::string_view(k_doc)};
+    CHECK_EQ(doc.root().get_type(), T_DICT);
+    CHECK_EQ(doc.find_pointer("/users/1/name").get_view(), "bob");
+    CHECK_EQ(doc.find_path("users.1.age").get_value<int_t>(), 17);
+    CHECK_EQ(doc.root()["users"][0]["tags"].size(), 2u);
+    CHECK_EQ(doc.root()["users"][0]["skip"].raw(), R"({"deep": [[1], {"x": "]}"}]})");
+    CHECK(!doc.find_pointer("/users/2"));
+    CHECK(!doc.find_pointer("/users/x"));
+    CHECK(!doc.find_path("users.0.missing"));
+    CHECK(!doc.root()["users"]["name"]);
+
+    //物化的结果与完整解析一致
+    CHECK_EQ(doc.root().materialize().to_string(), Parser::from_string(k_doc).to_string());
+}
+
+TEST_CASE(lazy_escaped_keys)
+{
+    LazyDocument doc{std::string_view(k_doc)};
+    //JSON Pointer中~1表示'/'，~0表示'~'
+    CHECK_EQ(doc.find_pointer("/a~1b").get_value<int_t>(), 1);
+    CHECK_EQ(doc.find_pointer("/m~0n").get_value<int_t>(), 2);
+    CHECK(!doc.find_pointer("/a/b"));
+    //源文本中带转义的键按解码后的内容比较
+    CHECK_EQ(doc.find_pointer("/quo\"te").get_value<int_t>(), 3);
+    CHECK_EQ(doc.find_pointer("/caf\xc3\xa9").get_value<int_t>(), 4);
+    CHECK_EQ(doc.root()["esc\\aped"].get_value<int_t>(), 5);
+    CHECK_EQ(doc.find_pointer("/").get_value<int_t>(), 6);
+    CHECK_EQ(doc.find_pointer("").get_type(), T_DICT);
+}
+
+TEST_CASE(lazy_rejects_invalid)
+{
+    for (const char *bad : {"{\"a\": [1, 2}", "[1,]", "{\"a\" 1}", "[1] 2", "\"open", "[tru]"})
+        CHECK_THROWS(LazyDocument{std::string_view(bad)}, std::logic_error);
+    //注释替换为空白后偏移不变
+    LazyDocument doc{std::string_view("// head\n{\"a\": // c\n [1, 2]}")};
+    CHECK_EQ(doc.find_path("a.1").get_value<int_t>(), 2);
+}
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "magnum/fjson/ndjson.h"
+
+using namespace fjson;
+
+namespace
+{
+    //第i行为 {"i": i}，每隔bad_every行插入一行坏数据，返回每行的起始偏移
+    std::string make_lines(size_t count, size_t bad_every, std::vector<size_t> &offsets)
+    {
+        std::string text;
+        for (size_t i = 0; i < count; i++)
+        {
+            offsets.push_back(text.size());
+            if (bad_every && i % bad_every == bad_every - 1)
+                text += "{\"i\": " + std::to_string(i) + ",}\n";
+            else
+                text += "{\"i\": " + std::to_string(i) + "}\n";
+            if (i % 7 == 0)
+                text += "\n"; //空行被跳过
+        }
+        return text;
+    }
+} // namespace
+
+TEST_CASE(ndjson_ordered_with_bad_lines)
+{
+    std::vector<size_t> offsets;
+    const std::string text = make_lines(2000, 97, offsets);
+    NdjsonOptions options;
+    options.threads = 3;
+    options.chunk_size = 256; //很多小块，乱序完成的概率很高
+    options.max_inflight = 4;
+    NdjsonReader reader(text, options);
+
+    NdjsonRecord record;
+    size_t i = 0;
+    for (; reader.next(record); i++)
+    {
+        if (i >= offsets.size())
+            break;
+        CHECK_EQ(record.offset, offsets[i]);
+        if (i % 97 == 96)
+        {
+            CHECK(!record.ok());
+        }
+        else
+        {
+            CHECK(record.ok());
+            if (record.ok())
+                CHECK_EQ(record.value["i"].get_value<int_t>(), static_cast<int_t>(i));
+        }
+    }
+    CHECK_EQ(i, offsets.size());
+    CHECK(!reader.next(record));
+}
+
+TEST_CASE(ndjson_unordered_delivers_everything)
+{
+    std::vector<size_t> offsets;
+    const std::string text = make_lines(1000, 0, offsets);
+    NdjsonOptions options;
+    options.threads = 4;
+    options.chunk_size = 100;
+    options.ordered = false;
+    NdjsonReader reader(text, options);
+
+    std::vector<size_t> seen;
+    NdjsonRecord record;
+    while (reader.next(record))
+    {
+        CHECK(record.ok());
+        seen.push_back(record.offset);
+    }
+    std::sort(seen.begin(), seen.end());
+    CHECK(seen == offsets);
+}
+
+TEST_CASE(ndjson_edge_inputs)
+{
+    NdjsonRecord record;
+    {
+        NdjsonReader reader(std::string_view(""));
+        CHECK(!reader.next(record));
+    }
+    {
+        //最后一行没有换行符，行尾的\r被忽略
+        NdjsonReader reader(std::string_view("[1]\r\n\n  \n\"x\""));
+        CHECK(reader.next(record));
+        CHECK_EQ(record.value.to_string(), "[1]");
+        CHECK(reader.next(record));
+        CHECK_EQ(record.offset, 9u);
+        CHECK_EQ(record.value.get_view(), "x");
+        CHECK(!reader.next(record));
+    }
+    {
+        //提前销毁读取器时不会卡住
+        std::vector<size_t> offsets;
+        const std::string text = make_lines(5000, 0, offsets);
+        NdjsonOptions options;
+        options.chunk_size = 64;
+        options.max_inflight = 2;
+        NdjsonReader reader(text, options);
+        CHECK(reader.next(record));
+    }
+}
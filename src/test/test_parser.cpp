@@ -0,0 +1,376 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "magnum/fjson/array_split.h"
+#include "magnum/fjson/parser.h"
+#include "magnum/threadpool/threadpool.h"
+
+using namespace fjson;
+
+namespace
+{
+    std::string read_file(const std::string &path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+
+    //逐字节的参考实现，索引规则见structural_index.h；遇到字符串外的'/'或未闭合的字符串时返回false。
+    //与向量化实现一致，字符串外的反斜杠同样转义下一个字符（这样的输入本身不是合法的json）
+    bool reference_index(std::string_view src, std::vector<uint32_t> &index)
+    {
+        index.clear();
+        bool in_string = false;
+        bool escaped = false;
+        bool prev_scalar = false;
+        for (size_t i = 0; i < src.size(); i++)
+        {
+            const char ch = src[i];
+            const bool quote = ch == '"' && !escaped;
+            escaped = ch == '\\' && !escaped;
+            if (in_string)
+            {
+                if (quote)
+                {
+                    in_string = false;
+                    index.push_back(static_cast<uint32_t>(i));
+                }
+                prev_scalar = false;
+                continue;
+            }
+            bool scalar = false;
+            if (quote)
+            {
+                in_string = true;
+                index.push_back(static_cast<uint32_t>(i));
+            }
+            else if (ch == '{' || ch == '}' || ch == '[' || ch == ']' || ch == ':' || ch == ',')
+            {
+                index.push_back(static_cast<uint32_t>(i));
+            }
+            else if (ch == '/')
+            {
+                return false;
+            }
+            else if (ch != ' ' && ch != '\t' && ch != '\n' && ch != '\v' && ch != '\f' && ch != '\r')
+            {
+                scalar = true;
+                if (!prev_scalar)
+                    index.push_back(static_cast<uint32_t>(i));
+            }
+            prev_scalar = scalar;
+        }
+        return !in_string;
+    }
+
+    //深度为depth的嵌套数组
+    std::string nested(size_t depth)
+    {
+        return std::string(depth, '[') + std::string(depth, ']');
+    }
+} // namespace
+
+TEST_CASE(parse_zero_copy_buffer)
+{
+    std::string buf = R"({"short": "abc", "long": "a string longer than the inline capacity"})";
+    JsonObject obj = Parser::from_buffer(buf);
+    JsonObject &lng = obj["long"];
+    CHECK(lng.is_view());
+    CHECK(!obj["short"].is_view()); //短字符串存放在节点内，不引用输入
+    CHECK(lng.get_view().data() >= buf.data() && lng.get_view().data() < buf.data() + buf.size());
+
+    obj.materialize();
+    CHECK(!lng.is_view());
+    std::fill(buf.begin(), buf.end(), 'x');
+    CHECK_EQ(lng.get_view(), "a string longer than the inline capacity");
+    CHECK_EQ(obj["short"].get_view(), "abc");
+}
+
+TEST_CASE(parse_document_zero_copy)
+{
+    const std::string src = R"({"name": "a string longer than the inline capacity", "list": [1, 2, 3]})";
+    Document doc = Parser::parse_document(src, true, true);
+    CHECK(doc.root()["name"].is_view());
+    //移动文档不改变arena与输入，借用的字符串仍然有效
+    Document moved(std::move(doc));
+    CHECK_EQ(moved.root()["name"].get_view(), "a string longer than the inline capacity");
+    CHECK_EQ(moved.root()["list"].get_value<list_t>().size(), 3u);
+
+    Document copied = Parser::parse_document(src);
+    CHECK(!copied.root()["name"].is_view());
+    CHECK_EQ(copied.root().to_string(), moved.root().to_string());
+}
+
+TEST_CASE(parse_entry_points_agree)
+{
+    const std::string path = "test/test.json";
+    const std::string text = read_file(path);
+    CHECK(!text.empty());
+    const std::string expected = read_file("test/test_out.json");
+
+    CHECK_EQ(Parser::from_string(text).to_string(), expected);
+    CHECK_EQ(Parser::from_buffer(text).to_string(), expected);
+    Document doc = Parser::from_file(path);
+    CHECK_EQ(doc.source().size(), text.size());
+    CHECK_EQ(doc.root().to_string(), expected);
+    CHECK_THROWS(Parser::from_file("test/no_such_file.json"), std::exception);
+}
+
+TEST_CASE(structural_index_matches_scalar)
+{
+    std::mt19937 rng(7);
+    const char alphabet[] = "{}[]:,\"\\ \t\nab1-.e0tfu";
+    std::vector<uint32_t> index;
+    std::vector<uint32_t> expected;
+    //长度覆盖不足一块、恰好一块、跨多块以及奇数长度，起始地址覆盖各种未对齐的偏移
+    for (size_t len : {0, 1, 7, 31, 63, 64, 65, 127, 129, 191, 1001})
+    {
+        for (size_t offset = 0; offset < 8; offset++)
+        {
+            for (int round = 0; round < 20; round++)
+            {
+                std::string storage(offset + len, ' ');
+                for (size_t i = 0; i < len; i++)
+                    storage[offset + i] = alphabet[rng() % (sizeof(alphabet) - 1)];
+                const std::string_view src(storage.data() + offset, len);
+                const bool ok = build_structural_index(src, index);
+                const bool expected_ok = reference_index(src, expected);
+                CHECK_EQ(ok, expected_ok);
+                if (ok && expected_ok)
+                    CHECK(index == expected);
+            }
+        }
+    }
+}
+
+TEST_CASE(structural_index_escapes_across_blocks)
+{
+    //反斜杠序列跨越64字节的块边界
+    for (size_t slashes = 1; slashes <= 5; slashes++)
+    {
+        std::string src = "[\"" + std::string(60, 'a') + std::string(slashes, '\\') + "\"" + "x\"]";
+        std::vector<uint32_t> index;
+        std::vector<uint32_t> expected;
+        const bool ok = build_structural_index(src, index);
+        CHECK_EQ(ok, reference_index(src, expected));
+        CHECK(index == expected);
+    }
+}
+
+TEST_CASE(number_edge_cases)
+{
+    JsonObject zero = Parser::from_string("-0");
+    CHECK_EQ(zero.get_type(), T_INT);
+    CHECK_EQ(zero.get_value<int_t>(), 0);
+
+    JsonObject neg_zero = Parser::from_string("-0.0");
+    CHECK_EQ(neg_zero.get_type(), T_DOUBLE);
+    CHECK(std::signbit(neg_zero.get_value<double_t>()));
+
+    JsonObject huge = Parser::from_string("1e400");
+    CHECK_EQ(huge.get_type(), T_DOUBLE);
+    CHECK(std::isinf(huge.get_value<double_t>()));
+    CHECK(std::isinf(Parser::from_string("-1e400").get_value<double_t>()));
+    CHECK_EQ(Parser::from_string("1e-400").get_value<double_t>(), 0.0);
+
+    JsonObject min = Parser::from_string("-9223372036854775808");
+    CHECK_EQ(min.get_type(), T_INT);
+    CHECK_EQ(min.get_value<int_t>(), std::numeric_limits<int64_t>::min());
+    JsonObject max = Parser::from_string("9223372036854775807");
+    CHECK_EQ(max.get_type(), T_INT);
+    CHECK_EQ(max.get_value<int_t>(), std::numeric_limits<int64_t>::max());
+
+    //超出int64的正整数存为uint64，再大则退化为double
+    JsonObject above = Parser::from_string("9223372036854775808");
+    CHECK_EQ(above.get_type(), T_UINT);
+    CHECK_EQ(above.get_value<uint_t>(), uint64_t(9223372036854775808ull));
+    JsonObject umax = Parser::from_string("18446744073709551615");
+    CHECK_EQ(umax.get_type(), T_UINT);
+    CHECK_EQ(umax.get_value<uint_t>(), std::numeric_limits<uint64_t>::max());
+    CHECK_EQ(umax.to_string(), "18446744073709551615");
+    CHECK_EQ(Parser::from_string("18446744073709551616").get_type(), T_DOUBLE);
+    CHECK_EQ(Parser::from_string("-9223372036854775809").get_type(), T_DOUBLE);
+
+    CHECK_EQ(Parser::from_string("1E2").get_value<double_t>(), 100.0);
+    CHECK_EQ(Parser::from_string("2.5e-3").get_value<double_t>(), 0.0025);
+    CHECK_THROWS(max.get_value<int32_t>(), std::out_of_range);
+    CHECK_THROWS(Parser::from_string("-"), std::logic_error);
+    CHECK_THROWS(Parser::from_string("1."), std::logic_error);
+    CHECK_THROWS(Parser::from_string("1e"), std::logic_error);
+    CHECK_THROWS(Parser::from_string("[.5]"), std::logic_error);
+}
+
+TEST_CASE(string_unicode)
+{
+    //代理对组合为一个4字节的UTF-8字符
+    CHECK_EQ(Parser::from_string(R"("😀")").get_view(), "\xf0\x9f\x98\x80");
+    CHECK_EQ(Parser::from_string(R"("é中")").get_view(), "\xc3\xa9\xe4\xb8\xad");
+    CHECK_EQ(Parser::from_string("\"\xc3\xa9\"").get_view(), "\xc3\xa9");
+    CHECK_THROWS(Parser::from_string(R"("\ud83d")"), std::logic_error);
+    CHECK_THROWS(Parser::from_string(R"("\ude00\ud83d")"), std::logic_error);
+    CHECK_THROWS(Parser::from_string(R"("\ud83dx")"), std::logic_error);
+    CHECK_THROWS(Parser::from_string(R"("\u12g4")"), std::logic_error);
+
+    //非法的UTF-8：孤立的续字节、截断的多字节序列、超长编码、代理区的码点
+    for (const char *bad : {"\"\xff\"", "\"\x80\"", "\"\xc3\"", "\"\xc0\xaf\"", "\"\xed\xa0\x80\""})
+        CHECK_THROWS(Parser::from_string(bad), std::logic_error);
+
+    //字符串中未转义的控制字符，键与值都要拒绝；字符串之外的空白不受影响
+    for (const char *bad : {"\"a\tb\"", "[\"\x01\"]", "{\"k\n\": 1}", "{\"k\": \"\x1f\"}"})
+    {
+        CHECK_THROWS(Parser::from_string(bad), std::logic_error);
+        CHECK_THROWS(Parser::from_buffer(bad), std::logic_error);
+    }
+    CHECK_EQ(Parser::from_string("{\t\"k\":\n\"v\"\r\n}")["k"].get_view(), "v");
+
+    //输出时控制字符转义，非ASCII字符原样保留
+    JsonObject obj = Parser::from_string(R"("a\tb\u0001é")");
+    CHECK_EQ(obj.to_string(), "\"a\\tb\\u0001\xc3\xa9\"");
+}
+
+TEST_CASE(depth_limit)
+{
+    const size_t saved = Parser::max_depth();
+    CHECK_NOTHROW(Parser::from_string(nested(saved)));
+    CHECK_THROWS(Parser::from_string(nested(saved + 1)), std::logic_error);
+
+    Parser::set_max_depth(8);
+    CHECK_NOTHROW(Parser::from_string(nested(8)));
+    CHECK_THROWS(Parser::from_string(nested(9)), std::logic_error);
+    CHECK_THROWS(Parser::from_string(R"({"a":{"b":{"c":{"d":{"e":{"f":{"g":{"h":{"i":1}}}}}}}}})"), std::logic_error);
+    CHECK_THROWS(Parser::set_max_depth(Parser::k_max_depth_limit + 1), std::invalid_argument);
+    Parser::set_max_depth(saved);
+
+    //深层的树可以正常拷贝、序列化与析构
+    Parser::set_max_depth(Parser::k_max_depth_limit);
+    JsonObject deep = Parser::from_string(nested(Parser::k_max_depth_limit));
+    JsonObject copy = deep;
+    CHECK_EQ(copy.to_string(), nested(Parser::k_max_depth_limit));
+    Parser::set_max_depth(saved);
+
+    //单个解析器的上限只影响它自己，下一次init恢复为全局默认值
+    const std::string src = nested(8);
+    Parser parser;
+    parser.init(src);
+    parser.set_depth_limit(4);
+    CHECK_EQ(parser.depth_limit(), 4u);
+    CHECK_THROWS(parser.parse(), std::logic_error);
+    parser.init(src);
+    CHECK_EQ(parser.depth_limit(), saved);
+    CHECK_NOTHROW(parser.parse());
+    CHECK_NOTHROW(Parser::from_string(nested(saved)));
+    CHECK_THROWS(parser.set_depth_limit(Parser::k_max_depth_limit + 1), std::invalid_argument);
+}
+
+TEST_CASE(deep_copy_without_recursion)
+{
+    //远超深度上限的树：拷贝使用显式的栈，不会耗尽调用栈
+    const size_t depth = 200000;
+    JsonObject deep((list_t()));
+    JsonObject *cur = &deep;
+    for (size_t i = 0; i < depth; i++)
+    {
+        cur->push_back(JsonObject(dict_t()));
+        JsonObject &child = cur->get_value<list_t>().back();
+        child["s"] = JsonObject("a string longer than the inline capacity");
+        child["k"] = JsonObject(list_t());
+        cur = &child["k"];
+    }
+    JsonObject copy = deep;
+    size_t levels = 0;
+    for (JsonObject *node = &copy; !node->get_value<list_t>().empty(); levels++)
+    {
+        JsonObject &child = node->get_value<list_t>()[0];
+        CHECK_EQ(child["s"].get_view(), "a string longer than the inline capacity");
+        node = &child["k"];
+    }
+    CHECK_EQ(levels, depth);
+
+    JsonObject shallow = Parser::from_string(R"([[{"a": [{}], "b": "x"}], {"c": {"d": [1, 2.5, null]}}])");
+    JsonObject other;
+    other = shallow;
+    CHECK_EQ(other.to_string(), shallow.to_string());
+}
+
+TEST_CASE(parse_parallel_matches_serial)
+{
+    std::string src = "[";
+    for (int i = 0; i < 5000; i++)
+    {
+        if (i)
+            src += ",";
+        src += R"({"id": )" + std::to_string(i) + R"(, "name": "item, [)" + std::to_string(i) +
+               R"(]\"", "tags": [1, {"x": "}"}], "v": )" + std::to_string(i * 0.5) + "}";
+    }
+    src += "]";
+
+    threadpool::ThreadPool pool(4);
+    const std::string serial = Parser::from_string(src).to_string();
+    CHECK_EQ(Parser::parse_parallel(src, pool).to_string(), serial);
+    JsonObject obj = Parser::from_string(src);
+    CHECK_EQ(Parser::to_string_parallel(obj, pool), serial);
+
+    //不是数组、空数组或数组很短时退回顺序解析
+    CHECK_EQ(Parser::parse_parallel("[]", pool).to_string(), "[]");
+    CHECK_EQ(Parser::parse_parallel(R"({"a": [1, 2]})", pool).to_string(), R"({"a":[1,2]})");
+    CHECK_THROWS(Parser::parse_parallel("[1, 2,", pool), std::logic_error);
+}
+
+TEST_CASE(parse_parallel_large_input)
+{
+    //超过并行阈值的输入，中间有一个跨越多块的大元素
+    std::string src = "[";
+    for (int i = 0; i < 20000; i++)
+        src += R"({"id": )" + std::to_string(i) + R"(, "s": "a,b]\"c"}, )";
+    src += "[\"" + std::string(1 << 20, 'x') + "\"], ";
+    for (int i = 0; i < 20000; i++)
+        src += "[" + std::to_string(i) + ", {}], ";
+    src += "null]";
+
+    threadpool::ThreadPool pool(4);
+    std::vector<std::string_view> ranges;
+    CHECK(split_top_array(src, 16, pool, ranges));
+    CHECK(ranges.size() > 2);
+    std::string joined = "[";
+    for (size_t i = 0; i < ranges.size(); i++)
+        joined += std::string(i ? "," : "") + std::string(ranges[i]);
+    CHECK_EQ(joined + "]", src);
+    CHECK_EQ(Parser::parse_parallel(src, pool).to_string(), Parser::from_string(src).to_string());
+
+    //元素的深度从1开始计算，达到上限的嵌套在并行与顺序解析时结果相同
+    const size_t saved = Parser::max_depth();
+    Parser::set_max_depth(8);
+    const std::string fits = src.substr(0, src.size() - 5) + nested(7) + "]";
+    const std::string deep = src.substr(0, src.size() - 5) + nested(8) + "]";
+    CHECK_EQ(Parser::parse_parallel(fits, pool).to_string(), Parser::from_string(fits).to_string());
+    CHECK_THROWS(Parser::from_string(deep), std::logic_error);
+    CHECK_THROWS(Parser::parse_parallel(deep, pool), std::logic_error);
+    Parser::set_max_depth(saved);
+}
+
+TEST_CASE(parse_many_keeps_order)
+{
+    std::vector<std::string> texts;
+    for (int i = 0; i < 64; i++)
+        texts.push_back("[" + std::to_string(i) + "]");
+    std::vector<std::string_view> docs(texts.begin(), texts.end());
+    threadpool::ThreadPool pool(3);
+    std::vector<JsonObject> res = Parser::parse_many(docs, pool);
+    CHECK_EQ(res.size(), texts.size());
+    for (size_t i = 0; i < res.size(); i++)
+        CHECK_EQ(res[i].to_string(), texts[i]);
+
+    docs[10] = "[1,";
+    CHECK_THROWS(Parser::parse_many(docs, pool), std::logic_error);
+}
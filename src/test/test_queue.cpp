@@ -0,0 +1,401 @@
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "magnum/threadsafe/mpmc_queue.h"
+#include "magnum/threadsafe/queue.h"
+#include "magnum/threadsafe/spsc_queue.h"
+
+namespace
+{
+    const int k_producers = 3;
+    const int k_consumers = 3;
+    const int k_per_producer = 20000;
+
+    //多个生产者各自入队[p * k_per_producer, (p + 1) * k_per_producer)，
+    //消费者出队直到取满，检查每个值恰好出现一次，且同一生产者的值保持先后顺序
+    template <class Push, class Pop>
+    void stress(Push push, Pop pop)
+    {
+        const int total = k_producers * k_per_producer;
+        std::vector<std::atomic<int>> seen(total);
+        std::atomic<int> popped{0};
+        std::atomic<bool> ordered{true};
+
+        std::vector<std::thread> threads;
+        for (int p = 0; p < k_producers; p++)
+            threads.emplace_back([&, p]
+                                 {
+                                     for (int i = 0; i < k_per_producer; i++)
+                                         push(p * k_per_producer + i); });
+        for (int c = 0; c < k_consumers; c++)
+            threads.emplace_back([&]
+                                 {
+                                     std::vector<int> last(k_producers, -1);
+                                     int value = 0;
+                                     while (popped.load() < total)
+                                     {
+                                         if (!pop(value))
+                                             continue;
+                                         popped++;
+                                         seen[value]++;
+                                         const int p = value / k_per_producer;
+                                         if (value <= last[p])
+                                             ordered = false;
+                                         last[p] = value;
+                                     } });
+        for (auto &t : threads)
+            t.join();
+
+        CHECK_EQ(popped.load(), total);
+        CHECK(ordered.load());
+        int duplicates = 0;
+        for (auto &count : seen)
+            duplicates += count.load() != 1;
+        CHECK_EQ(duplicates, 0);
+    }
+} // namespace
+
+TEST_CASE(queue_fifo)
+{
+    //原来的示例：三次入队，五次出队，后两次为空
+    threadsafe::queue<int> q;
+    for (int i = 0; i < 3; i++)
+        q.push(i);
+    for (int i = 0; i < 5; i++)
+    {
+        auto p = q.try_pop();
+        if (i < 3)
+        {
+            CHECK(p != nullptr);
+            if (p)
+                CHECK_EQ(*p, i);
+        }
+        else
+        {
+            CHECK(p == nullptr);
+        }
+    }
+
+    threadsafe::Queue<std::string> Q;
+    Q.push("a");
+    Q.push("b");
+    std::string value;
+    CHECK(Q.try_pop(value));
+    CHECK_EQ(value, "a");
+    CHECK_EQ(*Q.wait_pop(), "b");
+    CHECK(Q.empty());
+    CHECK(!Q.try_pop(value));
+}
+
+TEST_CASE(queue_stress)
+{
+    threadsafe::queue<int> q;
+    stress([&](int v)
+           { q.push(v); },
+           [&](int &v)
+           { return q.wait_pop_for(v, std::chrono::milliseconds(1)); });
+
+    threadsafe::Queue<int> Q;
+    stress([&](int v)
+           { Q.push(v); },
+           [&](int &v)
+           { return Q.try_pop(v); });
+}
+
+TEST_CASE(mpmc_queue_stress)
+{
+    threadsafe::MPMCQueue<int> q(64);
+    CHECK_EQ(q.capacity(), 64u);
+    stress([&](int v)
+           { q.push(v); },
+           [&](int &v)
+           { return q.try_pop(v); });
+
+    //容量很小时生产者会挂起等待
+    threadsafe::MPMCQueue<int> tiny(2);
+    stress([&](int v)
+           { tiny.push(v); },
+           [&](int &v)
+           { return tiny.try_pop(v); });
+    CHECK(tiny.empty());
+
+    //消费者挂起后由入队唤醒
+    std::thread consumer([&]
+                         {
+                             int v = 0;
+                             for (int i = 0; i < 100; i++)
+                             {
+                                 tiny.wait_pop(v);
+                                 CHECK_EQ(v, i);
+                             } });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    for (int i = 0; i < 100; i++)
+        tiny.push(i);
+    consumer.join();
+    CHECK(tiny.empty());
+}
+
+TEST_CASE(mpmc_queue_full_and_destroy)
+{
+    auto counter = std::make_shared<int>(0);
+    {
+        threadsafe::MPMCQueue<std::shared_ptr<int>> q(3);
+        CHECK_EQ(q.capacity(), 4u);
+        for (int i = 0; i < 4; i++)
+            CHECK(q.try_push(counter));
+        CHECK(!q.try_push(counter));
+        CHECK_EQ(counter.use_count(), 5);
+        std::shared_ptr<int> out;
+        CHECK(q.try_pop(out));
+        CHECK(q.try_push(std::move(out)));
+    }
+    //析构时销毁剩余的元素
+    CHECK_EQ(counter.use_count(), 1);
+    CHECK_THROWS(threadsafe::MPMCQueue<int>(0), std::invalid_argument);
+}
+
+TEST_CASE(spsc_queue_order_and_bulk)
+{
+    const int total = 200000;
+    threadsafe::SPSCQueue<int> q(128);
+    std::thread producer([&]
+                         {
+                             std::vector<int> batch;
+                             for (int i = 0; i < total;)
+                             {
+                                 if (i % 3 == 0)
+                                 {
+                                     q.push(i++);
+                                     continue;
+                                 }
+                                 batch.clear();
+                                 for (int k = 0; k < 37 && i < total; k++)
+                                     batch.push_back(i++);
+                                 q.push_bulk(batch.begin(), batch.end());
+                             } });
+    int expected = 0;
+    bool ordered = true;
+    std::vector<int> out;
+    while (expected < total)
+    {
+        out.clear();
+        if (expected % 2)
+        {
+            int value;
+            q.wait_pop(value);
+            out.push_back(value);
+        }
+        else
+        {
+            q.wait_pop_bulk(std::back_inserter(out), 50);
+        }
+        for (int value : out)
+            ordered = ordered && value == expected++;
+    }
+    producer.join();
+    CHECK(ordered);
+    CHECK(q.empty());
+
+    //输入迭代器：按块检查空位，空间不足时只入队一部分
+    threadsafe::SPSCQueue<int> small(4);
+    std::vector<int> items{1, 2, 3, 4, 5, 6};
+    auto first = items.begin();
+    CHECK_EQ(small.try_push_bulk(first, items.end()), 4u);
+    CHECK(first == items.begin() + 4);
+    CHECK_EQ(small.try_pop_bulk(std::back_inserter(out), 10), 4u);
+}
+
+TEST_CASE(queue_bulk_and_drain)
+{
+    threadsafe::queue<std::string> q;
+    std::vector<std::string> items{"a", "b", "c", "d"};
+    CHECK(q.push_bulk(items));
+    CHECK_EQ(items[0], "a"); //左值容器按拷贝入队
+    CHECK(q.push_bulk(std::vector<std::string>{"e", "f"}));
+    std::vector<std::string> out;
+    CHECK_EQ(q.try_pop_bulk(std::back_inserter(out), 3), 3u);
+    CHECK_EQ(q.wait_pop_bulk(std::back_inserter(out), 1), 1u);
+    CHECK_EQ(out.back(), "d");
+    std::vector<std::string> rest = q.drain_all();
+    CHECK_EQ(rest.size(), 2u);
+    CHECK_EQ(rest[1], "f");
+    CHECK(q.drain_all().empty());
+
+    threadsafe::Queue<std::string> Q;
+    CHECK(Q.push_bulk(items.begin(), items.end()));
+    out.clear();
+    CHECK_EQ(Q.try_pop_bulk(std::back_inserter(out), 10), 4u);
+    CHECK(Q.push_bulk(items));
+    CHECK_EQ(Q.drain_all().size(), 4u);
+
+    //批量入队按元素个数逐个唤醒阻塞的消费者，两种队列都不会漏掉
+    auto wake_all = [](auto &wq)
+    {
+        std::atomic<int> got{0};
+        std::vector<std::thread> consumers;
+        for (int i = 0; i < 4; i++)
+            consumers.emplace_back([&]
+                                   {
+                                       int v;
+                                       if (wq.wait_pop(v))
+                                           got++; });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        wq.push_bulk(std::vector<int>{1, 2});
+        wq.push_bulk(std::vector<int>{3, 4, 5});
+        for (auto &t : consumers)
+            t.join();
+        CHECK_EQ(got.load(), 4);
+        int v;
+        CHECK(wq.try_pop(v));
+        CHECK(!wq.try_pop(v));
+    };
+    threadsafe::queue<int> wq;
+    wake_all(wq);
+    threadsafe::Queue<int> WQ;
+    wake_all(WQ);
+}
+
+namespace
+{
+    //移动计数到达throw_at时抛出，live统计尚未销毁的对象
+    struct Fragile
+    {
+        static inline int live = 0;
+        static inline int moves = 0;
+        static inline int throw_at = -1;
+        std::unique_ptr<int> value;
+
+        explicit Fragile(int v) : value(new int(v)) { live++; }
+        Fragile(Fragile &&other) : value(std::move(other.value))
+        {
+            if (++moves == throw_at)
+                throw std::runtime_error("move failed");
+            live++;
+        }
+        Fragile &operator=(Fragile &&other) = default;
+        ~Fragile() { live--; }
+    };
+} // namespace
+
+TEST_CASE(queue_drain_all_move_throws)
+{
+    {
+        threadsafe::queue<Fragile> q;
+        for (int i = 0; i < 5; i++)
+            q.push(Fragile(i));
+        Fragile::throw_at = Fragile::moves + 3;
+        CHECK_THROWS(q.drain_all(), std::runtime_error);
+        Fragile::throw_at = -1;
+        //剩下的元素已随抛出销毁，节点被回收，队列仍可继续使用
+        CHECK_EQ(Fragile::live, 0);
+        CHECK(q.try_pop() == nullptr);
+        q.push(Fragile(9));
+        std::shared_ptr<Fragile> item = q.try_pop();
+        CHECK(item && *item->value == 9);
+    }
+    CHECK_EQ(Fragile::live, 0);
+}
+
+TEST_CASE(queue_close_and_timeouts)
+{
+    threadsafe::queue<int> q;
+    int value = 0;
+    auto start = std::chrono::steady_clock::now();
+    CHECK(!q.wait_pop_for(value, std::chrono::milliseconds(20)));
+    CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20));
+
+    //关闭唤醒所有阻塞的消费者，已入队的元素仍可取出
+    std::vector<std::thread> waiters;
+    std::atomic<int> woke{0};
+    for (int i = 0; i < 3; i++)
+        waiters.emplace_back([&]
+                             {
+                                 int v;
+                                 if (!q.wait_pop(v))
+                                     woke++; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    q.close();
+    for (auto &t : waiters)
+        t.join();
+    CHECK_EQ(woke.load(), 3);
+    CHECK(q.closed());
+    CHECK(!q.try_push(1));
+    q.push(2); //push不报告结果，关闭后元素被丢弃
+    CHECK(q.wait_pop() == nullptr);
+
+    threadsafe::Queue<int> Q;
+    CHECK(Q.try_push(7));
+    Q.close();
+    CHECK(!Q.try_push(8));
+    Q.push(8);
+    CHECK(!Q.push_bulk(std::vector<int>{9}));
+    CHECK(Q.wait_pop(value));
+    CHECK_EQ(value, 7);
+    CHECK(!Q.wait_pop(value));
+    CHECK(!Q.wait_pop_until(value, std::chrono::steady_clock::now() + std::chrono::seconds(10)));
+    std::vector<int> out;
+    CHECK_EQ(Q.wait_pop_bulk(std::back_inserter(out), 4), 0u);
+}
+
+TEST_CASE(bounded_queue_close)
+{
+    //MPMCQueue：关闭唤醒挂起在满队列上的生产者与空队列上的消费者
+    threadsafe::MPMCQueue<int> full(2);
+    CHECK(full.push(1));
+    CHECK(full.push(2));
+    std::atomic<int> rejected{0};
+    std::thread producer([&]
+                         {
+                             if (!full.push(3))
+                                 rejected++; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    full.close();
+    producer.join();
+    CHECK_EQ(rejected.load(), 1);
+    CHECK(full.closed());
+    CHECK(!full.try_push(4));
+    int value = 0;
+    CHECK(full.wait_pop(value));
+    CHECK_EQ(value, 1);
+    CHECK(full.try_pop(value));
+    CHECK(!full.wait_pop(value));
+
+    threadsafe::MPMCQueue<int> idle(4);
+    std::vector<std::thread> consumers;
+    for (int i = 0; i < 3; i++)
+        consumers.emplace_back([&]
+                               {
+                                   int v;
+                                   if (!idle.wait_pop(v))
+                                       rejected++; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    idle.close();
+    for (auto &t : consumers)
+        t.join();
+    CHECK_EQ(rejected.load(), 4);
+
+    //SPSCQueue：自旋中的生产者与消费者看到关闭后返回
+    threadsafe::SPSCQueue<int> spsc(1);
+    CHECK(spsc.push(1));
+    std::thread spsc_producer([&]
+                              {
+                                  std::vector<int> more{2, 3};
+                                  if (!spsc.push(4) && !spsc.push_bulk(more.begin(), more.end()))
+                                      rejected++; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    spsc.close();
+    spsc_producer.join();
+    CHECK_EQ(rejected.load(), 5);
+    std::vector<int> out;
+    CHECK_EQ(spsc.wait_pop_bulk(std::back_inserter(out), 4), 1u);
+    CHECK_EQ(out.front(), 1);
+    CHECK_EQ(spsc.wait_pop_bulk(std::back_inserter(out), 4), 0u);
+    CHECK(!spsc.wait_pop(value));
+}
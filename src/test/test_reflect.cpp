@@ -0,0 +1,102 @@
+#include <array>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "magnum/fjson/parser.h"
+
+using namespace fjson;
+
+namespace
+{
+    struct Address
+    {
+        std::string city;
+        int zip = 0;
+        FJSON_FIELDS(Address, FJSON_FIELD(city), FJSON_FIELD(zip))
+    };
+
+    struct Person
+    {
+        std::string name;
+        int64_t id = 0;
+        uint64_t big = 0;
+        double score = 0;
+        bool active = false;
+        std::optional<int> age;
+        std::vector<std::string> tags;
+        std::array<int, 3> dims{};
+        std::map<std::string, int> counts;
+        Address addr;
+        std::vector<Address> history;
+        FJSON_FIELDS(Person, FJSON_FIELD(name), FJSON_FIELD(id), FJSON_FIELD(big), FJSON_FIELD(score),
+                     FJSON_FIELD(active), FJSON_FIELD(age), FJSON_FIELD(tags), FJSON_FIELD(dims),
+                     FJSON_FIELD(counts), FJSON_FIELD_AS(addr, "address"), FJSON_FIELD(history))
+    };
+
+    Person sample()
+    {
+        Person p;
+        p.name = "Ann \"A\"\n";
+        p.id = -9223372036854775807 - 1;
+        p.big = 18446744073709551615ull;
+        p.score = 0.1;
+        p.active = true;
+        p.tags = {"x", "y"};
+        p.dims = {1, 2, 3};
+        p.counts = {{"a", 1}, {"b", 2}};
+        p.addr = {"Paris", 75001};
+        p.history = {{"Rome", 100}, {"Oslo", 150}};
+        return p;
+    }
+} // namespace
+
+TEST_CASE(fields_encode)
+{
+    const std::string json = Parser::ToJSON(sample());
+    CHECK_EQ(json, R"({"name":"Ann \"A\"\n","id":-9223372036854775808,"big":18446744073709551615,"score":0.1,)"
+                   R"("active":true,"age":null,"tags":["x","y"],"dims":[1,2,3],"counts":{"a":1,"b":2},)"
+                   R"("address":{"city":"Paris","zip":75001},"history":[{"city":"Rome","zip":100},{"city":"Oslo","zip":150}]})");
+    //与经过JsonObject的结果一致
+    CHECK_EQ(Parser::from_string(json).to_string(), json);
+}
+
+TEST_CASE(fields_decode)
+{
+    const Person p = Parser::FromJSON<Person>(Parser::ToJSON(sample()));
+    const Person expected = sample();
+    CHECK_EQ(p.name, expected.name);
+    CHECK_EQ(p.id, expected.id);
+    CHECK_EQ(p.big, expected.big);
+    CHECK_EQ(p.score, expected.score);
+    CHECK_EQ(p.active, true);
+    CHECK(!p.age);
+    CHECK(p.tags == expected.tags);
+    CHECK(p.dims == expected.dims);
+    CHECK(p.counts == expected.counts);
+    CHECK_EQ(p.addr.city, "Paris");
+    CHECK_EQ(p.addr.zip, 75001);
+    CHECK_EQ(p.history.size(), 2u);
+    CHECK_EQ(p.history[1].city, "Oslo");
+
+    //成员顺序任意，未知的键整体跳过，缺失的键保持默认值
+    const Person q = Parser::FromJSON<Person>(
+        R"({"unknown": {"deep": [1, {"x": "}"}]}, "age": 42, "name": "Bé", "extra": "s", "address": {"zip": 7}})");
+    CHECK_EQ(q.name, "B\xc3\xa9");
+    CHECK(q.age && *q.age == 42);
+    CHECK_EQ(q.addr.zip, 7);
+    CHECK(q.addr.city.empty());
+    CHECK(q.tags.empty());
+}
+
+TEST_CASE(fields_decode_errors)
+{
+    CHECK_THROWS(Parser::FromJSON<Address>(R"({"zip": "7"})"), std::logic_error);
+    CHECK_THROWS(Parser::FromJSON<Address>(R"({"zip": 1.5})"), std::logic_error);
+    CHECK_THROWS(Parser::FromJSON<Address>(R"({"zip": 9999999999})"), std::out_of_range);
+    CHECK_THROWS(Parser::FromJSON<Address>(R"({"city": "x"} 1)"), std::logic_error);
+    CHECK_THROWS(Parser::FromJSON<Address>(R"({"city": "x")"), std::logic_error);
+    CHECK_THROWS(Parser::FromJSON<Person>(R"({"dims": [1, 2, 3, 4]})"), std::out_of_range);
+}
@@ -0,0 +1,124 @@
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "magnum/fjson/sax_parser.h"
+
+using namespace fjson;
+
+namespace
+{
+    //把事件记录为一行文本，便于比较不同分块方式下的结果
+    class Recorder : public SaxHandler
+    {
+    public:
+        std::string events;
+
+        void null() override { events += "n "; }
+        void boolean(bool value) override { events += value ? "t " : "f "; }
+        void integer(int64_t value) override { events += "i" + std::to_string(value) + " "; }
+        void unsigned_integer(uint64_t value) override { events += "u" + std::to_string(value) + " "; }
+        void number(double value) override { events += "d" + std::to_string(value) + " "; }
+        void string(std::string_view value) override { events += "s<" + std::string(value) + "> "; }
+        void key(std::string_view value) override { events += "k<" + std::string(value) + "> "; }
+        void start_object() override { events += "{ "; }
+        void end_object() override { events += "} "; }
+        void start_array() override { events += "[ "; }
+        void end_array() override { events += "] "; }
+    };
+
+    std::string feed_whole(std::string_view src)
+    {
+        Recorder rec;
+        SaxParser parser(rec);
+        parser.feed(src);
+        parser.finish();
+        return rec.events;
+    }
+
+    //在cut处切成两块
+    std::string feed_split(std::string_view src, size_t cut)
+    {
+        Recorder rec;
+        SaxParser parser(rec);
+        parser.feed(src.substr(0, cut));
+        parser.feed(src.substr(cut));
+        parser.finish();
+        return rec.events;
+    }
+
+    std::string feed_bytes(std::string_view src)
+    {
+        Recorder rec;
+        SaxParser parser(rec);
+        for (char ch : src)
+            parser.feed(std::string_view(&ch, 1));
+        parser.finish();
+        return rec.events;
+    }
+} // namespace
+
+TEST_CASE(sax_events)
+{
+    CHECK_EQ(feed_whole(R"({"a": [1, -2.5, true, null, "x"], "b": {}})"),
+             "{ k<a> [ i1 d-2.500000 t n s<x> ] k<b> { } } ");
+    CHECK_EQ(feed_whole("18446744073709551615"), "u18446744073709551615 ");
+    CHECK_EQ(feed_whole(R"("\u00e9\ud83d\ude00\n")"), "s<\xc3\xa9\xf0\x9f\x98\x80\n> ");
+}
+
+TEST_CASE(sax_chunk_boundaries)
+{
+    //切分点落在字符串、转义序列、\u转义、代理对、数字、字面量和注释中间
+    const std::string src = "// lead\n{\"key \\\"q\\\"\": [12345.678e-2, -0, true, false, null],\n"
+                            " // line comment\n"
+                            " \"s\": \"caf\\u00e9 \\ud83d\\ude00 \\\\ end\", \"n\": -9223372036854775808 // tail\n}";
+    const std::string expected = feed_whole(src);
+    CHECK(expected.find("k<key \"q\"> [ d123.456780 i0 t f n ]") != std::string::npos);
+    CHECK(expected.find("s<caf\xc3\xa9 \xf0\x9f\x98\x80 \\ end> k<n> i-9223372036854775808 }") != std::string::npos);
+    for (size_t cut = 0; cut <= src.size(); cut++)
+        CHECK_EQ(feed_split(src, cut), expected);
+    CHECK_EQ(feed_bytes(src), expected);
+}
+
+TEST_CASE(sax_rejects_bad_input)
+{
+    for (const char *bad : {"[1,]", "{\"a\" 1}", "[1 2]", "\"abc", "[", "01", "1.", "tru", "{\"a\":1}}", "\"\\x\"",
+                            "\"\xff\"", "[1] [2]", "/ 1", "\"a\tb\"", "{\"k\n\": 1}", "[\"\x01\"]"})
+    {
+        CHECK_THROWS(feed_whole(bad), std::logic_error);
+        CHECK_THROWS(feed_bytes(bad), std::logic_error);
+    }
+}
+
+TEST_CASE(sax_depth_and_token_limits)
+{
+    Recorder rec;
+    SaxParser parser(rec, 4, 16);
+    CHECK_NOTHROW(parser.feed("[[[[]]]]"));
+    CHECK_NOTHROW(parser.finish());
+
+    parser.reset();
+    CHECK_THROWS(parser.feed("[[[[["), std::logic_error);
+
+    //单个token超过max_token时报错，即使它跨越多个块
+    parser.reset();
+    parser.feed("\"0123456789");
+    CHECK_THROWS(parser.feed("0123456789\""), std::logic_error);
+}
+
+TEST_CASE(sax_comments)
+{
+    //最后一行注释可以没有换行，包括'//'本身被切到两个块中
+    CHECK_EQ(feed_whole("[1] // tail"), "[ i1 ] ");
+    CHECK_EQ(feed_split("[1] // tail", 5), "[ i1 ] ");
+    CHECK_EQ(feed_bytes("[1]//"), "[ i1 ] ");
+    CHECK_EQ(feed_whole("{\"a\" // k\n : // v\n 1// n\n}"), "{ k<a> i1 } ");
+    CHECK_EQ(feed_whole("// only\n// lines\n\"x\""), "s<x> ");
+
+    //单独的'/'和块注释都是语法错误
+    for (const char *bad : {"[1] /", "/", "[1 /]", "/* block */ 1", "[1] /* open", "// only a comment"})
+    {
+        CHECK_THROWS(feed_whole(bad), std::logic_error);
+        CHECK_THROWS(feed_bytes(bad), std::logic_error);
+    }
+}
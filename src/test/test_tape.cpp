@@ -0,0 +1,143 @@
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+
+#include "check.h"
+#include "magnum/fjson/parser.h"
+#include "magnum/fjson/tape.h"
+
+using namespace fjson;
+
+namespace
+{
+    const char *k_doc = R"({"name":"a string longer than the inline capacity","n":[-1,18446744073709551615,0.5,true,null],)"
+                        R"("nested":{"name":"x","z":{},"list":[]},"esc":"q\"\u0001"})";
+
+    //遍历整棵树，损坏的磁带只允许抛出异常，不能越界读取
+    void walk(const TapeValue &value)
+    {
+        switch (value.get_type())
+        {
+        case T_LIST:
+            for (size_t i = 0; i < value.size(); i++)
+                walk(value[i]);
+            break;
+        case T_DICT:
+            for (size_t i = 0; i < value.size(); i++)
+            {
+                value.key_at(i);
+                walk(value.value_at(i));
+            }
+            break;
+        case T_STRING:
+            value.get_view();
+            break;
+        default:
+            break;
+        }
+    }
+} // namespace
+
+TEST_CASE(tape_round_trip)
+{
+    JsonObject obj = Parser::from_string(k_doc);
+    Tape tape = Tape::from_json(obj);
+    CHECK_EQ(tape.to_text(), obj.to_string());
+    CHECK_EQ(tape.root().to_json().to_string(), obj.to_string());
+
+    TapeValue root = tape.root();
+    CHECK_EQ(root["name"].get_view(), "a string longer than the inline capacity");
+    CHECK_EQ(root["n"][0].get_int(), -1);
+    CHECK_EQ(root["n"][1].get_uint(), 18446744073709551615ull);
+    CHECK_EQ(root["n"][2].get_double(), 0.5);
+    CHECK(root["n"][3].get_bool());
+    CHECK_EQ(root["n"][4].get_type(), T_NULL);
+    CHECK(!root["missing"]);
+    CHECK(!root["n"][5]);
+    CHECK_EQ(root.find_pointer("/nested/name").get_view(), "x");
+    CHECK_EQ(root.find_path("nested.list").size(), 0u);
+    CHECK_EQ(root["esc"].get_view(), "q\"\x01");
+
+    const std::string path = (std::filesystem::temp_directory_path() / "fjson_tape_test.tape").string();
+    tape.save(path);
+    {
+        Tape loaded = Tape::load(path);
+        CHECK_EQ(loaded.to_text(), obj.to_string());
+        Tape moved(std::move(loaded));
+        CHECK_EQ(moved.root()["nested"]["name"].get_view(), "x");
+    }
+    std::remove(path.c_str());
+
+    CHECK_EQ(Tape::from_text(k_doc).to_text(), obj.to_string());
+}
+
+TEST_CASE(tape_rejects_corrupt)
+{
+    Tape tape = Tape::from_text(k_doc);
+    const std::string bytes(tape.data());
+
+    CHECK_THROWS(Tape(std::string_view()), std::runtime_error);
+    CHECK_THROWS(Tape(std::string_view(bytes).substr(0, bytes.size() - 1)), std::runtime_error);
+    std::string bad_magic = bytes;
+    bad_magic[0] = 'X';
+    CHECK_THROWS(Tape{bad_magic}, std::runtime_error);
+    std::string bad_version = bytes;
+    bad_version[4] = 99;
+    CHECK_THROWS(Tape{bad_version}, std::runtime_error);
+
+    //随机改写头部之后的字节：要么仍能读取，要么抛出std::runtime_error
+    std::mt19937 rng(3);
+    size_t rejected = 0;
+    for (int round = 0; round < 2000; round++)
+    {
+        std::string mutated = bytes;
+        for (int k = 0; k < 3; k++)
+            mutated[16 + rng() % (mutated.size() - 16)] = static_cast<char>(rng());
+        try
+        {
+            Tape broken{mutated};
+            walk(broken.root());
+            broken.to_text();
+        }
+        catch (const std::runtime_error &)
+        {
+            rejected++;
+        }
+    }
+    CHECK(rejected > 0);
+}
+
+TEST_CASE(tape_without_content)
+{
+    Tape empty;
+    CHECK_THROWS(empty.root(), std::logic_error);
+    CHECK_THROWS(empty.to_text(), std::logic_error);
+
+    Tape tape = Tape::from_text("[1]");
+    Tape moved(std::move(tape));
+    CHECK_THROWS(tape.root(), std::logic_error);
+    CHECK_EQ(moved.to_text(), "[1]");
+}
+
+TEST_CASE(tape_deep_nesting)
+{
+    //编码不递归，超过文本解析深度上限的树也能写成磁带；读取时按深度上限拒绝
+    const size_t depth = Parser::max_depth() * 4;
+    JsonObject deep((list_t()));
+    JsonObject *cur = &deep;
+    for (size_t i = 1; i < depth; i++)
+    {
+        cur->push_back(JsonObject(dict_t()));
+        JsonObject &child = cur->get_value<list_t>().back();
+        child["k"] = JsonObject(list_t());
+        cur = &child["k"];
+    }
+    Tape tape = Tape::from_json(deep);
+    CHECK(tape.data().size() > depth);
+    CHECK_THROWS(tape.to_text(), std::runtime_error);
+
+    JsonObject shallow = Parser::from_string(R"([[{"a": [{}]}], {"b": {"c": []}}])");
+    CHECK_EQ(Tape::from_json(shallow).to_text(), shallow.to_string());
+}
@@ -0,0 +1,103 @@
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "check.h"
+#include "magnum/fjson/parser.h"
+#include "magnum/fjson/writer.h"
+
+using namespace fjson;
+
+namespace
+{
+    const char *k_sample = R"({"name":"a \"quoted\" \\ value\n","n":[0,-1,9223372036854775807,18446744073709551615,)"
+                           R"(0.1,-2.5e-8,1e+300],"flags":{"t":true,"f":false,"z":null},"empty":{},"list":[],)"
+                           R"("ctrl":"\u0001\u001f","utf8":"café 中"})";
+} // namespace
+
+TEST_CASE(writer_round_trip)
+{
+    JsonObject obj = Parser::from_string(k_sample);
+    const std::string compact = obj.to_string();
+    //输出可以再次解析，且再次输出完全一致
+    CHECK_EQ(Parser::from_string(compact).to_string(), compact);
+    CHECK(compact.find(R"("name":"a \"quoted\" \\ value\n")") != std::string::npos);
+    CHECK(compact.find(R"("ctrl":"\u0001\u001f")") != std::string::npos);
+    CHECK(compact.find("18446744073709551615") != std::string::npos);
+
+    WriteOptions pretty;
+    pretty.pretty = true;
+    pretty.indent = 2;
+    const std::string indented = obj.to_string(pretty);
+    CHECK(indented.find("\n  \"name\": ") != std::string::npos);
+    CHECK_EQ(Parser::from_string(indented).to_string(), compact);
+
+    //浮点数使用最短可往返表示
+    JsonObject num = Parser::from_string("[0.1, 1e+300, 5e-324]");
+    JsonObject again = Parser::from_string(num.to_string());
+    CHECK_EQ(again.get_value<list_t>()[0].get_value<double_t>(), 0.1);
+    CHECK_EQ(again.get_value<list_t>()[1].get_value<double_t>(), 1e300);
+    CHECK_EQ(again.get_value<list_t>()[2].get_value<double_t>(), 5e-324);
+}
+
+TEST_CASE(writer_events)
+{
+    Writer writer;
+    writer.start_object();
+    writer.key("a");
+    writer.start_array();
+    writer.integer(-3);
+    writer.unsigned_integer(18446744073709551615ull);
+    writer.number(0.5);
+    writer.boolean(true);
+    writer.null();
+    writer.raw_value(R"({"raw":1})");
+    writer.end_array();
+    writer.key("k\"");
+    writer.string("v\t");
+    writer.end_object();
+    CHECK_EQ(writer.take(), R"({"a":[-3,18446744073709551615,0.5,true,null,{"raw":1}],"k\"":"v\t"})");
+}
+
+TEST_CASE(writer_streams_to_sinks)
+{
+    JsonObject obj = Parser::from_string(k_sample);
+    obj["long"] = std::string(100000, 'x') + "\"" + std::string(100000, 'y'); //长字符串分块转义写出
+    const std::string expected = obj.to_string();
+
+    std::string collected;
+    size_t calls = 0;
+    CallbackSink callback([&](std::string_view data)
+                          { collected.append(data); calls++; });
+    Writer writer(callback, WriteOptions(), 1024);
+    writer.write(obj);
+    writer.flush();
+    CHECK_EQ(collected, expected);
+    CHECK(calls > 1);
+
+    std::string buf(expected.size(), '\0');
+    BufferSink fits(&buf[0], buf.size());
+    write_to(fits, obj);
+    CHECK_EQ(fits.view(), expected);
+
+    std::string small(16, '\0');
+    BufferSink too_small(&small[0], small.size());
+    CHECK_THROWS(write_to(too_small, obj), std::length_error);
+
+    const std::string path = (std::filesystem::temp_directory_path() / "fjson_writer_test.json").string();
+    FILE *file = std::fopen(path.c_str(), "wb");
+    CHECK(file != nullptr);
+    if (file)
+    {
+        FileSink sink(file);
+        write_to(sink, obj);
+        std::fclose(file);
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        CHECK_EQ(ss.str(), expected);
+        std::remove(path.c_str());
+    }
+}
@@ -1,16 +1,30 @@
 add_rules("mode.debug", "mode.release")
 
--- target("fjson")
---     set_kind("static")
---     add_includedirs("src/magnum/fjson", {public = true})
---     add_files("src/magnum/fjson/*.cpp")
+set_languages("c++17")
+
+target("fjson")
+    set_kind("static")
+    add_includedirs("src/magnum/fjson", {public = true})
+    add_files("src/magnum/fjson/*.cpp")
+    add_syslinks("pthread")
 
 target("threadsafe")
     set_kind("static")
     add_includedirs("src/magnum/threadsafe", {public = true})
 
+-- 单元测试：xmake build test && xmake run test [NAME]
 target("test")
     set_kind("binary")
-    add_files("src/test.cpp")
-    -- add_deps("fjson")
+    add_files("src/test.cpp", "src/test/*.cpp")
+    add_includedirs("src")
+    add_deps("fjson")
     add_deps("threadsafe")
+    set_rundir("$(projectdir)")
+
+-- 性能基准：xmake build bench && xmake run bench [--json] [--baseline FILE]
+target("bench")
+    set_kind("binary")
+    set_default(false)
+    add_files("src/bench.cpp")
+    add_deps("fjson")
+    set_rundir("$(projectdir)")